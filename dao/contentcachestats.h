@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// Memoization of converted content in Laser::show(...).
+class ContentCacheStats
+{
+    SERIALIZE_CLASS
+public serialized:
+    quint64 hits      = 0;
+    quint64 misses    = 0;
+    quint64 unchanged = 0;  // hits that were already playing, nothing was sent
+    qint32  entries   = 0;
+};
+
+}
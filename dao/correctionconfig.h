@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// Per projector output correction.
+class CorrectionConfig
+{
+    SERIALIZE_CLASS
+public serialized:
+    QVector<double> matrix;            // 3x3 row major, applied to (x, y, 1); empty -> identity
+    double          left   = -1.0;     // viewport, geometry outside gets clipped and blanked
+    double          bottom = -1.0;
+    double          right  =  1.0;
+    double          top    =  1.0;
+    QVector<quint8> red;               // 256 entries each; empty -> identity
+    QVector<quint8> green;
+    QVector<quint8> blue;
+    QVector<quint8> intensity;         // indexed by max(r, g, b); empty -> intensity stays 0
+};
+
+}
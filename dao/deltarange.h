@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// Changed points of a FrameDelta starting at index pos.
+// Coordinates are differences to the point at the same index of the base frame
+// in units of 1/16384 (points beyond the base frame count from 0.0 / 0.0 / black).
+// Empty x / y or r / g / b keep coordinates or colors of the base frame.
+class DeltaRange
+{
+    SERIALIZE_CLASS
+public serialized:
+    qint32          pos = 0;
+    QVector<qint32> x;
+    QVector<qint32> y;
+    QVector<quint8> r;  // absolute colors
+    QVector<quint8> g;
+    QVector<quint8> b;
+};
+
+using DeltaRanges = QVector<DeltaRange>;
+
+}
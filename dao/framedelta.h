@@ -0,0 +1,20 @@
+#pragma once
+
+#include <dao/deltarange.h>
+
+namespace dao {
+
+// Frame of a client stream, encoded as changes to a previous frame of the same stream.
+// baseSeq 0 is a key frame, which is applied to an empty frame.
+class FrameDelta
+{
+    SERIALIZE_CLASS
+public serialized:
+    quint32     stream  = 0;  // chosen by the client
+    quint32     seq     = 0;  // of this frame, > 0
+    quint32     baseSeq = 0;  // of the frame it is applied to
+    qint32      size    = 0;  // points of the resulting frame
+    DeltaRanges ranges;
+};
+
+}
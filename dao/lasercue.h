@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// TTL change synchronous to content: issued when the given point is played.
+// To trigger at the start of frame n, use n * points per frame.
+class LaserCue
+{
+    SERIALIZE_CLASS
+public serialized:
+    qint64 point = 0;  // index into the points of a show
+    quint8 ttl   = 0;
+};
+
+using LaserCues = QVector<LaserCue>;
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// One segment of a vector path, drawn from the end point of the previous segment.
+// Coordinates are in the same range as LaserPoint (-1.0 ... 1.0).
+class PathSegment
+{
+    SERIALIZE_CLASS
+public:
+    enum Type : quint8 { Move = 0, Line = 1, Quad = 2, Cubic = 3, Arc = 4 };
+
+public serialized:
+    quint8 type     = Move;
+    double x        = 0.0;    // end point
+    double y        = 0.0;
+    double x1       = 0.0;    // Quad, Cubic: first control point / Arc: radii
+    double y1       = 0.0;
+    double x2       = 0.0;    // Cubic: second control point / Arc: x2 is rotation in radians
+    double y2       = 0.0;
+    bool   largeArc = false;  // Arc flags as in SVG
+    bool   sweep    = false;
+    quint8 r        = 0;
+    quint8 g        = 0;
+    quint8 b        = 0;
+};
+
+using LaserPath = QVector<PathSegment>;
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// Simplification of the last show with a target refresh rate (see LevelOfDetail).
+class LevelOfDetailStats
+{
+    SERIALIZE_CLASS
+public serialized:
+    double targetRate   = 0.0;  // Hz
+    double achievedRate = 0.0;  // Hz, refresh rate of the shown frame
+    double error        = 0.0;  // max deviation from the input (full range = 2.0)
+    qint32 inputPoints  = 0;
+    qint32 shownPoints  = 0;
+    qint32 droppedRuns  = 0;    // sub-visible lit runs that are not shown
+};
+
+}
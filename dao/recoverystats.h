@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// Automatic reconnects after device errors (USB dropouts, replugging).
+class RecoveryStats
+{
+    SERIALIZE_CLASS
+public serialized:
+    quint64 errors         = 0;    // errors that started a recovery
+    quint64 reconnects     = 0;    // successful recoveries
+    quint64 failedAttempts = 0;
+    bool    isRecovering   = false;
+    double  lastRecovery   = 0.0;  // ms from error to reconnect
+    double  maxRecovery    = 0.0;  // ms
+};
+
+}
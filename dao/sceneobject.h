@@ -0,0 +1,22 @@
+#pragma once
+
+#include <dao/laserpoint.h>
+
+namespace dao {
+
+class SceneObject
+{
+    SERIALIZE_CLASS
+public serialized:
+    LaserPoints points;          // geometry in object coordinates
+    double      x        = 0.0;  // translation
+    double      y        = 0.0;
+    double      rotation = 0.0;  // radians
+    double      scale    = 1.0;
+    quint8      r        = 255;  // color multiplier
+    quint8      g        = 255;
+    quint8      b        = 255;
+    bool        visible  = true;
+};
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cflib/serialize/serialize.h>
+
+namespace dao {
+
+// Lateness of the device polling timer, shows the effect of real-time scheduling.
+class TimerStats
+{
+    SERIALIZE_CLASS
+public serialized:
+    quint64 count       = 0;
+    double  meanLatency = 0.0;  // us
+    double  maxLatency  = 0.0;  // us
+    quint64 lateCount   = 0;    // later than one polling interval
+};
+
+}
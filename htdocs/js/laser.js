@@ -4,29 +4,124 @@ const laserURL = new URL(document.currentScript.src).origin;
 Promise.all([
     import(laserURL + '/js/cflib/net/rmi.mjs'),
     import(laserURL + '/js/services/laserservice.mjs'),
-    import(laserURL + '/js/dao/laserpoint.mjs')
+    import(laserURL + '/js/dao/laserpoint.mjs'),
+    import(laserURL + '/js/dao/correctionconfig.mjs'),
+    import(laserURL + '/js/dao/lasercue.mjs'),
+    import(laserURL + '/js/dao/framedelta.mjs'),
+    import(laserURL + '/js/dao/deltarange.mjs')
 ]).then(mods => {
-    const rmi    = mods[0].default;
-    window.laser = mods[1].default;
-    laser.Point  = mods[2].default;
+    const rmi              = mods[0].default;
+    window.laser           = mods[1].default;
+    laser.Point            = mods[2].default;
+    laser.CorrectionConfig = mods[3].default;
+    laser.Cue              = mods[4].default;
+    laser.FrameDelta       = mods[5].default;
+    laser.DeltaRange       = mods[6].default;
 
     laser.errorCallback     = null;
     laser.activeCallback    = null;
     laser.finishedCallback  = null;
+    laser.presentedCallback = null;
+    laser.cueCallback       = null;
+    laser.completedCallback = null;
     laser.MaxSpeed          = 59899;
     laser.OptimalPointCount = 8190;
 
+    // Encodes the frames of one stream as changes to its previous frame (showDelta, appendStreamDelta).
+    // If the server returned false, reset() turns the next frame into a key frame.
+    laser.DeltaEncoder = class {
+        constructor(stream) {
+            this.stream = stream;
+            this.seq    = 0;
+            this.base   = null;
+        }
+
+        reset() {
+            this.base = null;
+        }
+
+        encode(points) {
+            const MaxGap = 4;  // unchanged points are cheaper than a new range
+            const fixed  = (v) => Math.max(-32768, Math.min(32767, Math.round(v * 16384)));
+            const frame  = points.map(p => ({ x: fixed(p.x), y: fixed(p.y), r: p.r | 0, g: p.g | 0, b: p.b | 0 }));
+            const base   = this.base || [];
+            const black  = { x: 0, y: 0, r: 0, g: 0, b: 0 };
+            const baseAt = (i) => i < base.length ? base[i] : black;
+
+            // changed index ranges
+            const spans = [];
+            for (let i = 0 ; i < frame.length ; ++i) {
+                const p = frame[i];
+                const o = baseAt(i);
+                if (p.x === o.x && p.y === o.y && p.r === o.r && p.g === o.g && p.b === o.b) continue;
+                const last = spans[spans.length - 1];
+                if (last && i - last.end <= MaxGap) last.end = i + 1;
+                else                                 spans.push({ begin: i, end: i + 1 });
+            }
+
+            const ranges = spans.map(span => {
+                const range = { pos: span.begin, x: [], y: [], r: [], g: [], b: [] };
+                let isMoved     = false;
+                let isRecolored = false;
+                for (let i = span.begin ; i < span.end ; ++i) {
+                    const p = frame[i];
+                    const o = baseAt(i);
+                    isMoved     = isMoved     || p.x !== o.x || p.y !== o.y;
+                    isRecolored = isRecolored || p.r !== o.r || p.g !== o.g || p.b !== o.b;
+                }
+                for (let i = span.begin ; i < span.end ; ++i) {
+                    const p = frame[i];
+                    const o = baseAt(i);
+                    if (isMoved) {
+                        range.x.push(p.x - o.x);
+                        range.y.push(p.y - o.y);
+                    }
+                    if (isRecolored) {
+                        range.r.push(p.r);
+                        range.g.push(p.g);
+                        range.b.push(p.b);
+                    }
+                }
+                return new laser.DeltaRange(range);
+            });
+
+            const delta = new laser.FrameDelta({
+                stream:  this.stream,
+                seq:     ++this.seq,
+                baseSeq: this.base ? this.seq - 1 : 0,
+                size:    frame.length,
+                ranges:  ranges
+            });
+            this.base = frame;
+            return delta;
+        }
+    };
+
     rmi.start(laserURL + '/ws');
-    laser.idle();
+    laser.idle(0);
     laser.rsig.error.bind((error) => {
         laser.errorCallback && laser.errorCallback(error);
     }).register();
     laser.rsig.active.bind((active) => {
         laser.activeCallback && laser.activeCallback(active);
     }).register();
-    laser.rsig.finished.bind(() => {
-        laser.finishedCallback && laser.finishedCallback();
+    laser.rsig.finished.bind((remaining) => {
+        laser.finishedCallback && laser.finishedCallback(remaining);
+    }).register();
+    laser.rsig.presented.bind((target, start) => {
+        laser.presentedCallback && laser.presentedCallback(target, start);
+    }).register();
+    laser.rsig.cue.bind((ttl, target, actual) => {
+        laser.cueCallback && laser.cueCallback(ttl, target, actual);
+    }).register();
+    // token: as given to on, off or idle
+    laser.rsig.completed.bind((command, token, ok) => {
+        laser.completedCallback && laser.completedCallback(command, token, ok);
     }).register();
+    // the preview costs bandwidth, so it is only registered on demand
+    laser.startPreview = (callback) => {
+        laser.rsig.preview.bind(callback).register();
+    };
     initLaser();
 });
 
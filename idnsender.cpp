@@ -0,0 +1,177 @@
+#include "idnsender.h"
+
+#include <cflib/util/log.h>
+
+#include <arpa/inet.h>
+#include <unistd.h>
+
+USE_LOG(LogCat::Network)
+
+using namespace idn;
+
+namespace {
+
+constexpr double SendInterval     = 0.005;  // seconds
+constexpr int    ConfigInterval   = 64;     // messages between repeated channel configurations
+constexpr int    SampleSize       = 7;      // XYRGB with 16 bit coordinates
+constexpr int    DescriptorWords  = 4;
+constexpr int    MaxHeaderSize    = HelloHeaderSize + MessageHeaderSize + ConfigHeaderSize + DescriptorWords * 4;
+constexpr int    SamplesPerPacket = (MaxPayloadSize - MaxHeaderSize - ChunkHeaderSize) / SampleSize;
+
+inline qint16 toSample(double v) { return qBound(-32767, qRound(v * 32767.0), 32767); }
+
+inline quint32 duration(qint64 samples) { return qRound64(samples * 1e6 / Laser::MaxSpeed); }
+
+}
+
+IdnSender::IdnSender(Stream & stream)
+:
+    ThreadVerify("IdnSender", Worker),
+    stream_(stream),
+    sendTimer_(this, &IdnSender::send)
+{
+}
+
+IdnSender::~IdnSender()
+{
+    stopVerifyThread();
+    if (fd_ < 0) return;
+    sendMessage(0, ConfigClose, QByteArray());
+    ::close(fd_);
+}
+
+bool IdnSender::start(const QByteArray & address, quint16 port, bool frames)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&IdnSender::start, address, port, frames)) return stc.retval();
+    logFunctionTrace
+
+    dest_ = sockaddr_in{};
+    dest_.sin_family = AF_INET;
+    dest_.sin_port   = htons(port);
+    if (inet_pton(AF_INET, address.constData(), &dest_.sin_addr) != 1) {
+        logWarn("invalid IDN address: %1", address);
+        return false;
+    }
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        logWarn("cannot create IDN socket: %1", strerror(errno));
+        return false;
+    }
+
+    isFrames_    = frames;
+    messages_    = 0;
+    startTime_   = Laser::now();
+    nextFrame_   = startTime_;
+    sentSamples_ = 0;
+    points_      = stream_.getFirst();
+    pos_         = 0;
+    logInfo("sending IDN %1 to %2:%3", frames ? "frames" : "wave", address, port);
+    send();
+    return true;
+}
+
+void IdnSender::send()
+{
+    const qint64 time = Laser::now();
+    if (!isFrames_) {
+        sendWave(time);
+    } else if (time >= nextFrame_) {
+        sendFrame();
+    }
+    sendTimer_.singleShot(SendInterval);
+}
+
+void IdnSender::sendWave(qint64 time)
+{
+    qint64 due = (time - startTime_) * Laser::MaxSpeed / 1000000 - sentSamples_;
+    while (due > 0) {
+        if (pos_ == points_.size()) {
+            points_ = stream_.getNext();
+            pos_    = 0;
+            if (points_.isEmpty()) return;
+        }
+
+        const qsizetype count = qMin<qsizetype>(qMin<qint64>(due, SamplesPerPacket), points_.size() - pos_);
+        QByteArray chunk;
+        chunk.reserve(ChunkHeaderSize + count * SampleSize);
+        append8 (chunk, 0);
+        append24(chunk, duration(sentSamples_ + count) - duration(sentSamples_));
+        appendSamples(chunk, pos_, count);
+        sendMessage(ChunkWave, ConfigRouting, chunk);
+
+        pos_         += count;
+        sentSamples_ += count;
+        due          -= count;
+    }
+}
+
+void IdnSender::sendFrame()
+{
+    // the first frame is still there from start(...)
+    if (pos_ > 0) points_ = stream_.getNext();
+    pos_ = points_.size();
+    if (points_.isEmpty()) return;
+    nextFrame_ += duration(points_.size());
+
+    QByteArray frame;
+    frame.reserve(ChunkHeaderSize + points_.size() * SampleSize);
+    append8 (frame, 0);
+    append24(frame, duration(points_.size()));
+    appendSamples(frame, 0, points_.size());
+
+    const int maxChunk = MaxPayloadSize - MaxHeaderSize;
+    if (frame.size() <= maxChunk) {
+        sendMessage(ChunkFrame, ConfigRouting, frame);
+        return;
+    }
+    sendMessage(ChunkFrameFirst, ConfigRouting, frame.mid(0, maxChunk));
+    for (qsizetype pos = maxChunk ; pos < frame.size() ; pos += maxChunk) {
+        sendMessage(ChunkFrameSequel, 0, frame.mid(pos, maxChunk), pos + maxChunk >= frame.size());
+    }
+}
+
+void IdnSender::sendMessage(quint8 type, quint8 configFlags, const QByteArray & chunk, bool isLast)
+{
+    // sequel fragments have no configuration, the flag marks the last one
+    const bool hasConfig = type == ChunkFrameSequel ? isLast :
+        configFlags & ConfigClose || messages_ % ConfigInterval == 0;
+    ++messages_;
+
+    QByteArray message;
+    message.reserve(MaxHeaderSize + chunk.size());
+    append16(message, 0);  // total size
+    append16(message, ContentChannelMessage | (hasConfig ? ContentConfig : 0) | type);
+    append32(message, (quint32)Laser::now());
+    if (hasConfig && type != ChunkFrameSequel) {
+        append8(message, DescriptorWords);
+        append8(message, configFlags);
+        append8(message, 0);  // service id
+        append8(message, isFrames_ ? ModeDiscrete : ModeContinuous);
+        for (quint16 tag : SampleFormat::defaultTags()) append16(message, tag);
+    }
+    message.append(chunk);
+    message[0] = (char)(message.size() >> 8);
+    message[1] = (char)message.size();
+
+    QByteArray packet;
+    packet.reserve(HelloHeaderSize + message.size());
+    append8 (packet, ChannelMessage);
+    append8 (packet, 0);
+    append16(packet, seq_++);
+    packet.append(message);
+    if (sendto(fd_, packet.constData(), packet.size(), 0, (const sockaddr *)&dest_, sizeof(dest_)) < 0) {
+        logWarn("cannot send IDN packet: %1", strerror(errno));
+    }
+}
+
+void IdnSender::appendSamples(QByteArray & chunk, qsizetype begin, qsizetype count) const
+{
+    for (qsizetype i = begin ; i < begin + count ; ++i) {
+        append16(chunk, toSample(points_.x(i)));
+        append16(chunk, toSample(points_.y(i)));
+        append8 (chunk, points_.r(i));
+        append8 (chunk, points_.g(i));
+        append8 (chunk, points_.b(i));
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <laser/idn.h>
+#include <stream.h>
+
+#include <cflib/util/evtimer.h>
+#include <cflib/util/threadverify.h>
+
+#include <netinet/in.h>
+
+// Sends the test stream as IDN stream over UDP (counterpart of IdnReceiver).
+// Wave mode sends chunks paced in real time, frame mode one frame per frame duration.
+class IdnSender : private cflib::util::ThreadVerify
+{
+public:
+    IdnSender(Stream & stream);
+    ~IdnSender();
+
+    // the channel is closed on destruction
+    bool start(const QByteArray & address, quint16 port, bool frames);
+
+private:
+    void send();
+    void sendWave(qint64 time);
+    void sendFrame();
+    void sendMessage(quint8 type, quint8 configFlags, const QByteArray & chunk, bool isLast = false);
+    void appendSamples(QByteArray & chunk, qsizetype begin, qsizetype count) const;
+
+private:
+    Stream &             stream_;
+    int                  fd_ = -1;
+    sockaddr_in          dest_;
+    bool                 isFrames_ = false;
+    cflib::util::EVTimer sendTimer_;
+    quint16              seq_ = 0;
+    int                  messages_ = 0;
+    qint64               startTime_ = 0;
+    qint64               sentSamples_ = 0;
+    qint64               nextFrame_ = 0;
+    Laser::Points        points_;
+    qsizetype            pos_ = 0;
+};
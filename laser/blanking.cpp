@@ -0,0 +1,27 @@
+#include "blanking.h"
+
+namespace {
+
+constexpr int JumpStep   = 80;  // max device units per point while blanked
+constexpr int JumpSettle =  8;  // blank points at both ends of a jump
+
+}
+
+void appendBlankJump(EasyLase::Points & points, EasyLase::Point from, EasyLase::Point to)
+{
+    if (from.x == to.x && from.y == to.y) return;
+    from.r = from.g = from.b = from.i = 0;
+    to.r   = to.g   = to.b   = to.i   = 0;
+
+    for (int i = 0 ; i < JumpSettle ; ++i) points << from;
+    const int dx = to.x - from.x;
+    const int dy = to.y - from.y;
+    const int steps = qMax(qAbs(dx), qAbs(dy)) / JumpStep;
+    for (int i = 1 ; i < steps ; ++i) {
+        points << EasyLase::Point{
+            .x = quint16(from.x + dx * i / steps),
+            .y = quint16(from.y + dy * i / steps)
+        };
+    }
+    for (int i = 0 ; i < JumpSettle ; ++i) points << to;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <laser/easylase.h>
+
+// Appends a blanked jump in device format from one point to another,
+// including settle points at both ends. Nothing is added if both points are equal.
+void appendBlankJump(EasyLase::Points & points, EasyLase::Point from, EasyLase::Point to);
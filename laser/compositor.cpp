@@ -0,0 +1,269 @@
+#include "compositor.h"
+
+#include <laser/blanking.h>
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+namespace {
+
+constexpr qint64 LeadTime   = 60000;  // us of composed frames ahead of the device
+constexpr double RetryDelay = 0.005;  // seconds
+
+inline qint64 duration(qsizetype points) { return points * 1000000LL / Laser::MaxSpeed; }
+
+}
+
+Compositor::Compositor(Laser & laser)
+:
+    ThreadVerify("Compositor", Worker),
+    laser_(laser),
+    updateTimer_(this, &Compositor::update)
+{
+}
+
+Compositor::~Compositor()
+{
+    stopVerifyThread();
+}
+
+bool Compositor::setZone(const QString & name, const ZoneConfig & config)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Compositor::setZone, name, config)) return stc.retval();
+    logFunctionTrace
+    if (!zones_.contains(name) && zones_.size() >= MaxZones) {
+        logWarn("cannot add zone %1, there are %2 zones already", name, MaxZones);
+        return false;
+    }
+    Zone & zone = zones_[name];
+    if (zone.repeat && !zone.points.isEmpty()) zone.isDirty = true;
+    zone.config = config;
+    changed();
+    return true;
+}
+
+void Compositor::removeZone(const QString & name)
+{
+    if (!verifyThreadCall(&Compositor::removeZone, name)) return;
+    logFunctionTrace
+    if (zones_.remove(name) > 0) changed();
+}
+
+void Compositor::clear()
+{
+    if (!verifyThreadCall(&Compositor::clear)) return;
+    logFunctionTrace
+    zones_.clear();
+    changed();
+}
+
+bool Compositor::show(const QString & name, const Laser::Points & points, bool repeat)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Compositor::show, name, points, repeat)) return stc.retval();
+    logFunctionTrace
+    if (!zones_.contains(name)) return false;
+    Zone & zone = zones_[name];
+    zone.repeat = repeat;
+    zone.pos    = 0;
+    if (repeat) {
+        zone.points = points;
+        zone.devicePoints.clear();
+        zone.isDirty = !points.isEmpty();
+    } else {
+        zone.points.clear();
+        zone.devicePoints = Laser::convert(points.toLaserPoints(), zone.config.pps);
+        zone.isDirty = false;
+    }
+    changed();
+    return true;
+}
+
+bool Compositor::append(const QString & name, const Laser::Points & points)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Compositor::append, name, points)) return stc.retval();
+    logFunctionTrace
+
+    if (!zones_.contains(name)) return false;
+    Zone & zone = zones_[name];
+    if (zone.repeat) {
+        zone.repeat = false;
+        zone.points.clear();
+        zone.devicePoints.clear();
+        zone.pos = 0;
+        zone.isDirty = false;
+    }
+    if (zone.devicePoints.size() - zone.pos > ZoneBufferLimit) return false;
+
+    if (zone.pos > 0) {
+        zone.devicePoints.remove(0, zone.pos);
+        zone.pos = 0;
+    }
+    zone.devicePoints += Laser::convert(points.toLaserPoints(), zone.config.pps);
+    changed();
+    return true;
+}
+
+Compositor::Stats Compositor::stats() const
+{
+    SyncedThreadCall<Stats> stc(this);
+    if (!stc.verify(&Compositor::stats)) return stc.retval();
+    Stats rv = stats_;
+    rv.zones = zones_.size();
+    return rv;
+}
+
+void Compositor::changed()
+{
+    isDirty_ = true;
+    update();
+}
+
+void Compositor::update()
+{
+    updateTimer_.stop();
+    const qint64 time = Laser::now();
+
+    // static content is sent once and repeated by Laser
+    if (!isDynamic()) {
+        if (!isDirty_ && !isStreaming_) return;
+        isDirty_ = false;
+
+        const EasyLase::Point  streamEnd = lastPoint_;
+        const EasyLase::Points frame     = compose(true);
+        if (isStreaming_) {
+            // it follows the streamed frames, which are already queued
+            isStreaming_ = false;
+            if (frame.isEmpty()) {
+                laser_.endStream(false);
+                isActive_ = false;
+                return;
+            }
+            EasyLase::Points jump;
+            appendBlankJump(jump, streamEnd, frame.first());
+            if (!jump.isEmpty()) laser_.appendConvertedStream(jump);
+            laser_.endConvertedStream(frame);
+            return;
+        }
+        if (!frame.isEmpty()) {
+            laser_.showConverted(frame, true);
+            isActive_ = true;
+        } else if (isActive_) {
+            laser_.idle();
+            isActive_ = false;
+        }
+        return;
+    }
+
+    // dynamic content is streamed a few frames ahead
+    if (!isStreaming_) {
+        laser_.beginStream(Laser::MaxSpeed);
+        isStreaming_  = true;
+        isActive_     = true;
+        hasLastPoint_ = false;
+        nextDue_      = time;
+        pendingFrame_.clear();
+    } else if (nextDue_ < time) {
+        ++stats_.underruns;
+        logDebug("composition is %1us late", time - nextDue_);
+        nextDue_ = time;
+    }
+    isDirty_ = false;
+
+    while (nextDue_ < time + LeadTime && isDynamic()) {
+        if (pendingFrame_.isEmpty()) pendingFrame_ = compose(false);
+        if (!laser_.appendConvertedStream(pendingFrame_)) {
+            // nothing of ours can be buffered anymore, another show took over
+            if (nextDue_ <= time) {
+                logDebug("output was taken over");
+                isStreaming_ = false;
+                isActive_    = false;
+                pendingFrame_.clear();
+                return;
+            }
+            updateTimer_.singleShot(RetryDelay);
+            return;
+        }
+        nextDue_ += duration(pendingFrame_.size());
+        pendingFrame_.clear();
+    }
+
+    // static content follows dynamic content
+    if (!isDynamic()) {
+        update();
+        return;
+    }
+    updateTimer_.singleShot(qMax<qint64>(0, nextDue_ - LeadTime / 2 - time) / 1e6);
+}
+
+bool Compositor::isDynamic() const
+{
+    if (!pendingFrame_.isEmpty()) return true;
+    for (const Zone & zone : zones_) {
+        if (!zone.repeat && zone.pos < zone.devicePoints.size()) return true;
+    }
+    return false;
+}
+
+QList<Compositor::Zone *> Compositor::ordered()
+{
+    QList<Zone *> rv;
+    for (Zone & zone : zones_) rv << &zone;
+    std::stable_sort(rv.begin(), rv.end(), [](const Zone * a, const Zone * b) { return a->config.order < b->config.order; });
+    return rv;
+}
+
+EasyLase::Points Compositor::compose(bool repeat)
+{
+    EasyLase::Points rv;
+    int converted = 0;
+    for (Zone * zone : ordered()) {
+        EasyLase::Points slice;
+        if (zone->repeat) {
+            if (zone->isDirty) {
+                // the budget is kept by resampling
+                dao::LaserPoints points = zone->points.toLaserPoints();
+                const int rep = Laser::replication(zone->config.pps);
+                if (zone->config.pointBudget > 0 && points.size() * rep > zone->config.pointBudget) {
+                    Resampler::Config config;
+                    config.pointBudget = qMax(1, zone->config.pointBudget / rep);
+                    points = Resampler(config).resample(points);
+                }
+                zone->devicePoints = Laser::convert(points, zone->config.pps);
+                zone->isDirty = false;
+                ++converted;
+            }
+            slice = zone->devicePoints;
+        } else {
+            const int       budget = zone->config.pointBudget > 0 ? zone->config.pointBudget : DefaultBudget;
+            const qsizetype count  = qMin<qsizetype>(budget, zone->devicePoints.size() - zone->pos);
+            if (count <= 0) continue;
+            slice = zone->devicePoints.mid(zone->pos, count);
+            zone->pos += count;
+            if (zone->pos == zone->devicePoints.size()) {
+                zone->devicePoints.clear();
+                zone->pos = 0;
+            }
+        }
+        if (slice.isEmpty()) continue;
+
+        if      (!rv.isEmpty())            appendBlankJump(rv, rv.last(), slice.first());
+        else if (!repeat && hasLastPoint_) appendBlankJump(rv, lastPoint_, slice.first());
+        rv += slice;
+    }
+    if (rv.isEmpty()) return rv;
+
+    // repeated frames return to their start, streamed ones continue from their end
+    if (repeat) appendBlankJump(rv, rv.last(), rv.first());
+    lastPoint_    = rv.last();
+    hasLastPoint_ = true;
+
+    ++stats_.frames;
+    stats_.conversions += converted;
+    stats_.lastFrame    = rv.size();
+    logTrace("composed frame of %1 zones with %2 points (%3 converted)", zones_.size(), rv.size(), converted);
+    return rv;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <laser/laser.h>
+
+#include <cflib/util/evtimer.h>
+#include <cflib/util/threadverify.h>
+
+// Shows the content of several named zones together on one Laser, stitched with blank jumps.
+// Repeated zone content is drawn completely in every composed frame,
+// one-shot and streamed content is played pointBudget device points per frame.
+// Static zones are converted once, a composition is only sent when a zone has changed
+// or dynamic content has to go on.
+// Other shows on the Laser replace the zones until the next change.
+class Compositor : private cflib::util::ThreadVerify
+{
+public:
+    static constexpr int DefaultBudget   = 2048;                     // device points per frame
+    static constexpr int ZoneBufferLimit = 8 * EasyLase::MaxPoints;  // buffered device points of a zone
+    static constexpr int MaxZones        = 16;
+
+    struct ZoneConfig
+    {
+        quint16 pps         = Laser::MaxSpeed;  // must not be 0
+        int     pointBudget = DefaultBudget;    // device points per frame, 0 -> unlimited for repeated content
+        int     order       = 0;                // drawing order, then by name
+    };
+
+    struct Stats
+    {
+        quint64 frames      = 0;  // composed frames
+        quint64 conversions = 0;  // converted repeated zone contents
+        quint64 underruns   = 0;  // dynamic content was late
+        int     zones       = 0;
+        int     lastFrame   = 0;  // device points
+    };
+
+public:
+    Compositor(Laser & laser);
+    ~Compositor();
+
+    // Creates or changes a zone, false if there are MaxZones already.
+    bool setZone(const QString & name, const ZoneConfig & config);
+    void removeZone(const QString & name);
+    void clear();
+
+    // Replaces the content of a zone. Empty points clear it.
+    // Returns false, if the zone was not set.
+    bool show(const QString & name, const Laser::Points & points, bool repeat);
+    // Appends to the one-shot content of a zone (replaces repeated content).
+    // Returns false, if the zone was not set or if too many points are buffered,
+    // in the latter case the chunk should be sent again later.
+    bool append(const QString & name, const Laser::Points & points);
+
+    Stats stats() const;
+
+private:
+    struct Zone
+    {
+        ZoneConfig       config;
+        Laser::Points    points;        // repeated content, converted if dirty
+        bool             repeat  = true;
+        bool             isDirty = false;
+        EasyLase::Points devicePoints;  // repeated content or buffered one-shot content
+        qsizetype        pos     = 0;   // played one-shot points
+    };
+
+    void changed();
+    void update();
+    bool isDynamic() const;
+    QList<Zone *> ordered();
+    EasyLase::Points compose(bool repeat);
+
+private:
+    Laser &              laser_;
+    QMap<QString, Zone>  zones_;
+    bool                 isDirty_      = false;
+    bool                 isActive_     = false;  // the last composition was sent to Laser
+    bool                 isStreaming_  = false;
+    qint64               nextDue_      = 0;      // us, end of the composed frames sent so far
+    EasyLase::Points     pendingFrame_;          // rejected by Laser, sent again
+    EasyLase::Point      lastPoint_;             // end of the last streamed frame
+    bool                 hasLastPoint_ = false;
+    Stats                stats_;
+    cflib::util::EVTimer updateTimer_;
+};
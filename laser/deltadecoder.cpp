@@ -0,0 +1,60 @@
+#include "deltadecoder.h"
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+namespace {
+
+inline qint16 addDelta(qint16 v, qint32 delta) { return (qint16)qBound<qint64>(-32768, (qint64)v + delta, 32767); }
+
+bool isValid(const dao::DeltaRange & range, qint32 size)
+{
+    const qsizetype count = qMax(range.x.size(), range.r.size());
+    return range.pos >= 0 && count <= size - range.pos &&
+        (range.x.isEmpty() || (range.x.size() == count && range.y.size() == count)) &&
+        (range.r.isEmpty() || (range.r.size() == count && range.g.size() == count && range.b.size() == count));
+}
+
+}
+
+bool DeltaDecoder::apply(const dao::FrameDelta & delta)
+{
+    // resent after a rejected stream chunk
+    if (delta.seq != 0 && delta.seq == seq_) return true;
+
+    const bool isKey = delta.baseSeq == 0;
+    if ((!isKey && delta.baseSeq != seq_) || delta.seq == 0 || delta.size < 0 || delta.size > MaxSize) {
+        logDebug("rejecting delta %1 of stream %2 on base %3 (have %4)", delta.seq, delta.stream, delta.baseSeq, seq_);
+        return false;
+    }
+    for (const dao::DeltaRange & range : delta.ranges) {
+        if (isValid(range, delta.size)) continue;
+        logDebug("rejecting delta %1 of stream %2 with invalid range at %3", delta.seq, delta.stream, range.pos);
+        return false;
+    }
+
+    // in place: only changed points are touched
+    if (isKey) frame_.clear();
+    const qsizetype baseSize = frame_.size();
+    frame_.resize(delta.size);
+    qint16 * x = frame_.xData();
+    qint16 * y = frame_.yData();
+    quint8 * r = frame_.rData();
+    quint8 * g = frame_.gData();
+    quint8 * b = frame_.bData();
+    for (const dao::DeltaRange & range : delta.ranges) {
+        for (qsizetype i = 0 ; i < range.x.size() ; ++i) {
+            x[range.pos + i] = addDelta(x[range.pos + i], range.x[i]);
+            y[range.pos + i] = addDelta(y[range.pos + i], range.y[i]);
+        }
+        if (range.r.isEmpty()) continue;
+        std::copy(range.r.cbegin(), range.r.cend(), r + range.pos);
+        std::copy(range.g.cbegin(), range.g.cend(), g + range.pos);
+        std::copy(range.b.cbegin(), range.b.cend(), b + range.pos);
+    }
+    seq_ = delta.seq;
+    logTrace("delta %1 of stream %2: %3 ranges, %4 -> %5 points", delta.seq, delta.stream, delta.ranges.size(),
+        baseSize, delta.size);
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <dao/framedelta.h>
+#include <laser/pointbuffer.h>
+
+// Rebuilds the frames of one client stream from dao::FrameDelta in its own buffer.
+// This class has no threading.
+class DeltaDecoder
+{
+public:
+    static constexpr qint32 MaxSize = 1 << 20;  // points per frame
+
+public:
+    // Returns false without changes, if the delta does not fit the current frame
+    // (unknown base, invalid ranges). The client has to send a key frame then.
+    // The delta of the current frame can be applied again, nothing changes.
+    bool apply(const dao::FrameDelta & delta);
+
+    quint32 seq() const { return seq_; }
+    const PointBuffer & frame() const { return frame_; }
+
+private:
+    quint32     seq_ = 0;
+    PointBuffer frame_;
+};
@@ -0,0 +1,107 @@
+#include "deviceclock.h"
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Etc)
+
+namespace {
+
+constexpr double MaxUncertainty = 3000.0;  // us, observations with bigger polling gaps are ignored
+constexpr double PhaseGain      = 0.25;    // share of observed error corrected at once
+constexpr double RateGain       = 0.5;
+constexpr double RateWindow     = 1e6;     // us of continuous playback per rate measurement
+constexpr double MaxDrift       = 0.02;    // relative to nominal pps
+constexpr int    MaxFrames      = 3;       // playing, queued and just submitted
+
+}
+
+DeviceClock::DeviceClock(double nominalPps) :
+    nominalPps_(nominalPps),
+    pps_(nominalPps)
+{
+}
+
+void DeviceClock::reset()
+{
+    frames_.clear();
+    anchorTime_   = -1;
+    anchorPoints_ = 0;
+}
+
+qint64 DeviceClock::submit(qint64 now, qsizetype points)
+{
+    const double start = frames_.isEmpty() ? now : qMax<double>(now, boundaryAfter(now));
+    if (!frames_.isEmpty()) {
+        Frame & last = frames_.last();
+        // repeated frames break continuous counting
+        if (start > last.end + 1.0) {
+            anchorTime_ = -1;
+            last.end = start;
+        }
+    }
+    frames_ << Frame{ .start = start, .end = start + points * 1e6 / pps_, .points = points };
+
+    // boundaries which were not observed
+    while (frames_.size() > MaxFrames) frames_.removeFirst();
+    return qRound64(start);
+}
+
+void DeviceClock::frameFinished(qint64 lastPoll, qint64 now)
+{
+    // the boundary is only visible, if another frame follows
+    if (frames_.size() < 2) return;
+    const Frame frame = frames_.takeFirst();
+    if (now - lastPoll > MaxUncertainty) {
+        anchorTime_ = -1;
+        return;
+    }
+
+    const double observed = (lastPoll + now) / 2.0;
+    lastError_ = observed - frame.end;
+    const double shift = PhaseGain * lastError_;
+    for (Frame & f : frames_) {
+        f.start += shift;
+        f.end   += shift;
+    }
+
+    if (anchorTime_ < 0) {
+        anchorTime_   = observed;
+        anchorPoints_ = 0;
+        return;
+    }
+    anchorPoints_ += frame.points;
+    const double window = observed - anchorTime_;
+    if (window < RateWindow) return;
+
+    const double measured = anchorPoints_ * 1e6 / window;
+    pps_ = qBound(nominalPps_ * (1.0 - MaxDrift), pps_ + RateGain * (measured - pps_), nominalPps_ * (1.0 + MaxDrift));
+    anchorTime_   = observed;
+    anchorPoints_ = 0;
+    logTrace("device clock: %1 pps, last error: %2us", pps_, qRound(lastError_));
+}
+
+qint64 DeviceClock::nextStart(qint64 now) const
+{
+    if (frames_.isEmpty()) return now;
+    return qRound64(qMax<double>(now, boundaryAfter(now)));
+}
+
+qint64 DeviceClock::submitTime(qint64 target) const
+{
+    if (frames_.isEmpty()) return target;
+
+    // boundary of the repeating frame nearest to target
+    const Frame & last = frames_.last();
+    const double duration = last.end - last.start;
+    if (duration <= 0.0) return target;
+    const double boundary = last.start + qMax(1.0, std::round((target - last.start) / duration)) * duration;
+    return qRound64(boundary - duration / 2);
+}
+
+double DeviceClock::boundaryAfter(double time) const
+{
+    const Frame & last = frames_.last();
+    const double duration = last.end - last.start;
+    if (time <= last.end || duration <= 0.0) return last.end;
+    return last.start + std::ceil((time - last.start) / duration) * duration;
+}
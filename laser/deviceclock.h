@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QtCore>
+
+// Predicts when submitted frames are played by the device.
+// The device holds two frames and repeats the last one, until the next one is there.
+// Frame boundaries observed by polling correct phase and point rate continuously.
+// All times are in us.
+// This class has no threading.
+class DeviceClock
+{
+public:
+    DeviceClock(double nominalPps);
+
+    // device buffers were cleared
+    void reset();
+
+    // Registers a frame submitted at time now and returns its predicted start.
+    qint64 submit(qint64 now, qsizetype points);
+
+    // Polling found a free buffer after both were full.
+    // The boundary was somewhere between lastPoll and now.
+    void frameFinished(qint64 lastPoll, qint64 now);
+
+    // predicted start of a frame submitted at time now
+    qint64 nextStart(qint64 now) const;
+
+    // Time at which a frame should be submitted to start as close as possible to target.
+    qint64 submitTime(qint64 target) const;
+
+    double pps() const { return pps_; }
+    qint64 lastError() const { return qRound64(lastError_); }  // last observed boundary minus prediction
+    qint64 duration(qsizetype points) const { return qRound64(points * 1e6 / pps_); }
+
+private:
+    struct Frame
+    {
+        double    start;
+        double    end;
+        qsizetype points;
+    };
+
+    double boundaryAfter(double time) const;
+
+private:
+    const double nominalPps_;
+    double       pps_;
+    double       lastError_ = 0.0;
+    QList<Frame> frames_;            // oldest is played, last one repeats
+    double       anchorTime_ = -1;   // first observed boundary of continuous playback
+    qsizetype    anchorPoints_ = 0;  // points played since then
+};
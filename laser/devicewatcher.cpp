@@ -0,0 +1,82 @@
+#include "devicewatcher.h"
+
+#include <laser/easylase.h>
+
+#include <cflib/util/log.h>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+USE_LOG(LogCat::Etc)
+
+namespace {
+
+constexpr int PollTimeout = 50;  // ms, stop() waits at most that long
+
+}
+
+DeviceWatcher::DeviceWatcher(VoidFunc callback)
+:
+    ThreadVerify("DeviceWatcher", Worker),
+    callback_(callback),
+    watchTimer_(this, &DeviceWatcher::watch)
+{
+}
+
+DeviceWatcher::~DeviceWatcher()
+{
+    stopVerifyThread();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool DeviceWatcher::start()
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&DeviceWatcher::start)) return stc.retval();
+    if (fd_ >= 0) return true;
+    logFunctionTrace
+
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0 || inotify_add_watch(fd_, EasyLase::DeviceDir, IN_CREATE | IN_ATTRIB | IN_MOVED_TO) < 0) {
+        logWarn("cannot watch %1 for devices: %2", EasyLase::DeviceDir, strerror(errno));
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    watchTimer_.singleShot(0);
+    return true;
+}
+
+void DeviceWatcher::stop()
+{
+    if (!verifyThreadCall(&DeviceWatcher::stop)) return;
+    if (fd_ < 0) return;
+    logFunctionTrace
+    watchTimer_.stop();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void DeviceWatcher::watch()
+{
+    if (fd_ < 0) return;
+    pollfd pfd{ .fd = fd_, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, PollTimeout) > 0) {
+        alignas(inotify_event) char buffer[4096];
+        bool isDevice = false;
+        ssize_t size;
+        while ((size = read(fd_, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t pos = 0 ; pos < size ; ) {
+                const inotify_event * event = reinterpret_cast<const inotify_event *>(buffer + pos);
+                if (event->len > 0 && EasyLase::isDeviceName(event->name)) {
+                    logDebug("device event for %1", event->name);
+                    isDevice = true;
+                }
+                pos += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (isDevice) callback_();
+    }
+    watchTimer_.singleShot(0);
+}
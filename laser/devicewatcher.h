@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cflib/util/evtimer.h>
+#include <cflib/util/threadverify.h>
+
+#include <QtCore>
+
+// Watches /dev with inotify for EasyLase devices being plugged in or getting their permissions.
+class DeviceWatcher : private cflib::util::ThreadVerify
+{
+public:
+    using VoidFunc = std::function<void ()>;
+
+public:
+    // attention: the callback is called from an internal thread
+    DeviceWatcher(VoidFunc callback);
+    ~DeviceWatcher();
+
+    bool start();
+    void stop();
+
+private:
+    void watch();
+
+private:
+    VoidFunc             callback_;
+    int                  fd_ = -1;
+    cflib::util::EVTimer watchTimer_;
+};
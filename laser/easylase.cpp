@@ -59,18 +59,26 @@ void EasyLase::connect()
     logFunctionTrace
     if (device_.isOpen()) disconnect();
     error_ = QString();
+
+    // replugged devices may come back with another number
+    device_.setFileName(DeviceName);
+    if (!device_.exists()) {
+        const QStringList names = QDir(DeviceDir).entryList({ "easylase*" }, QDir::System, QDir::Name);
+        if (!names.isEmpty()) device_.setFileName(QString("%1/%2").arg(DeviceDir, names.first()));
+    }
+
     bool ok = device_.open(QIODevice::ReadWrite | QIODevice::Unbuffered | QIODevice::ExistingOnly);
     if (!ok) {
-        check(false, QString("cannot connect to EasyLase device %1").arg(DeviceName));
+        check(false, QString("cannot connect to EasyLase device %1").arg(device_.fileName()));
     } else {
-        logInfo("connected to EasyLase device %1", DeviceName);
+        logInfo("connected to EasyLase device %1", device_.fileName());
     }
 }
 
 void EasyLase::disconnect()
 {
     device_.close();
-    logInfo("disconnected from EasyLase device %1", DeviceName);
+    logInfo("disconnected from EasyLase device %1", device_.fileName());
 }
 
 void EasyLase::setTTL(quint8 hiLow)
@@ -97,15 +105,15 @@ bool EasyLase::isReady()
     return false;
 }
 
-void EasyLase::show(quint16 pps, const Points & points)
+void EasyLase::show(quint16 pps, const Point * points, qsizetype count)
 {
     logFunctionTrace
-    if (!check(points.size() <= MaxPoints, QString("too many points: %1").arg(points.size()))) return;
+    if (!check(count <= MaxPoints, QString("too many points: %1").arg(count))) return;
     QByteArray data = LaserData;
     data += toByteArray(pps);
-    const quint16 size = points.size() * sizeof(Point);
+    const quint16 size = count * sizeof(Point);
     data += toByteArray(size);
-    data.append(reinterpret_cast<const char *>(points.data()), size);
+    data.append(reinterpret_cast<const char *>(points), size);
     logTrace("sending %1 bytes : %2", data.size(), data.toHex());
     check(device_.write(data) == data.size(), "laser data");
 }
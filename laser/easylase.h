@@ -8,6 +8,7 @@ public:
     static constexpr quint16 MinSpeed  = 500;
     static constexpr quint16 MaxSpeed  = 0xFFFF;
     static constexpr quint16 MaxPoints = 8190;
+    static constexpr const char * DeviceDir = "/dev";
 
     struct Point
     {
@@ -35,9 +36,13 @@ public:
     // This class has no threading.
     void setErrorCallback(VoidFunc callback) { errorCallback_ = callback; }
 
+    // Opens /dev/easylase0 or, if that is gone, the first other EasyLase device.
     void connect();
     void disconnect();
 
+    // file names of EasyLase devices in DeviceDir
+    static bool isDeviceName(const char * name) { return strncmp(name, "easylase", 8) == 0; }
+
     // no need to check isReady here
     // Attention:
     // Bits to Pin assignment is different than the description in the EasyLase USB manual.
@@ -59,7 +64,8 @@ public:
     // real speed for pps = MaxSpeed is 59.899 PPS => 137ms for 8190 points
     void idle();
     bool isReady();
-    void show(quint16 pps, const Points & points);
+    void show(quint16 pps, const Points & points) { show(pps, points.constData(), points.size()); }
+    void show(quint16 pps, const Point * points, qsizetype count);
     void show(const Point & point) { return show(MinSpeed, Points(1, point)); }
 
 private:
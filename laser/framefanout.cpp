@@ -0,0 +1,114 @@
+#include "framefanout.h"
+
+#include <cflib/util/log.h>
+#include <cflib/util/threadverify.h>
+
+#include <deque>
+
+USE_LOG(LogCat::Etc)
+
+class FrameFanout::Queue : public cflib::util::ThreadVerify
+{
+public:
+    Queue(std::shared_ptr<FrameSink> sink, const Config & config)
+    :
+        ThreadVerify("FrameSink", Worker),
+        sink_(sink),
+        config_(config)
+    {
+        config_.queueSize = qMax(1, config_.queueSize);
+    }
+
+    ~Queue()
+    {
+        stopVerifyThread();
+    }
+
+    void push(const FrameSink::FramePtr & frame)
+    {
+        QMutexLocker locker(&mutex_);
+        if ((int)frames_.size() >= config_.queueSize) {
+            ++stats_.dropped;
+            if (config_.policy == DropNewest) return;
+            frames_.pop_front();
+        }
+        frames_.push_back(frame);
+
+        // one pending call drains everything
+        if (isDraining_) return;
+        isDraining_ = true;
+        locker.unlock();
+        drain();
+    }
+
+    Stats stats() const
+    {
+        QMutexLocker locker(&mutex_);
+        Stats rv = stats_;
+        rv.queued = frames_.size();
+        return rv;
+    }
+
+private:
+    void drain()
+    {
+        if (!verifyThreadCall(&Queue::drain)) return;
+        for (;;) {
+            FrameSink::FramePtr frame;
+            {
+                QMutexLocker locker(&mutex_);
+                if (frames_.empty()) {
+                    isDraining_ = false;
+                    return;
+                }
+                frame = frames_.front();
+                frames_.pop_front();
+            }
+            // the device thread only waits for the short locks above
+            sink_->frame(frame);
+            QMutexLocker locker(&mutex_);
+            ++stats_.delivered;
+        }
+    }
+
+private:
+    std::shared_ptr<FrameSink>      sink_;
+    Config                          config_;
+    mutable QMutex                  mutex_;
+    std::deque<FrameSink::FramePtr> frames_;
+    bool                            isDraining_ = false;
+    Stats                           stats_;
+};
+
+FrameFanout::FrameFanout()
+{
+}
+
+FrameFanout::~FrameFanout()
+{
+}
+
+int FrameFanout::add(std::shared_ptr<FrameSink> sink, const Config & config)
+{
+    if (!sink) return 0;
+    queues_[++lastId_] = std::make_shared<Queue>(sink, config);
+    logDebug("frame sink %1 added (queue: %2, policy: %3)", lastId_, config.queueSize,
+        config.policy == DropOldest ? "drop oldest" : "drop newest");
+    return lastId_;
+}
+
+void FrameFanout::remove(int id)
+{
+    if (queues_.remove(id) > 0) logDebug("frame sink %1 removed", id);
+}
+
+void FrameFanout::deliver(const FrameSink::FramePtr & frame)
+{
+    for (const std::shared_ptr<Queue> & queue : queues_) queue->push(frame);
+}
+
+FrameFanout::Stats FrameFanout::stats(int id) const
+{
+    const std::shared_ptr<Queue> queue = queues_.value(id);
+    return queue ? queue->stats() : Stats();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <laser/framesink.h>
+
+// Delivers frames to any number of sinks, each with a bounded queue and its own thread.
+// deliver(...) never blocks, so slow sinks cannot hold back the device.
+// This class has no threading, all members must be called from one thread.
+class FrameFanout
+{
+public:
+    enum DropPolicy
+    {
+        DropOldest,  // a full queue drops its oldest frame (sinks that want to be current)
+        DropNewest   // a full queue rejects new frames (sinks that want contiguous runs)
+    };
+
+    struct Config
+    {
+        int        queueSize = 4;  // frames
+        DropPolicy policy    = DropOldest;
+    };
+
+    struct Stats
+    {
+        quint64 delivered = 0;
+        quint64 dropped   = 0;
+        int     queued    = 0;
+    };
+
+public:
+    FrameFanout();
+    ~FrameFanout();
+
+    // returns an id for remove(...) and stats(...)
+    int  add(std::shared_ptr<FrameSink> sink, const Config & config);
+    // waits until a running frame() call of the sink returned
+    void remove(int id);
+
+    bool isEmpty() const { return queues_.isEmpty(); }
+    void deliver(const FrameSink::FramePtr & frame);
+
+    Stats stats(int id) const;
+
+private:
+    class Queue;
+
+private:
+    int                               lastId_ = 0;
+    QMap<int, std::shared_ptr<Queue>> queues_;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <laser/easylase.h>
+
+#include <memory>
+
+// Receives copies of the frames submitted to the device (see Laser::addFrameSink(...)).
+// The device repeats the last frame until the next one arrives.
+class FrameSink
+{
+public:
+    // One submitted frame, shared by all sinks and never modified.
+    // A frame without points means that the device went idle.
+    struct Frame
+    {
+        quint64          seq;     // counts submitted frames
+        qint64           start;   // predicted start on the device in us (see Laser::now())
+        EasyLase::Points points;  // at EasyLase::MaxSpeed with output correction
+    };
+    using FramePtr = std::shared_ptr<const Frame>;
+
+public:
+    virtual ~FrameSink() {}
+
+    // called from a thread owned by the sink's queue, one frame at a time
+    virtual void frame(const FramePtr & frame) = 0;
+};
@@ -0,0 +1,86 @@
+#include "idn.h"
+
+#include <laser/laser.h>
+
+namespace idn {
+
+namespace {
+
+inline quint16 toAxis(const quint8 * p, int size)
+{
+    if (size == 2) return ((qint16)read16(p) + 32768) >> 4;
+    return ((qint8)p[0] + 128) << 4;
+}
+
+}
+
+const QVector<quint16> & SampleFormat::defaultTags()
+{
+    static const QVector<quint16> tags{
+        TagX, TagPrecision16, TagY, TagPrecision16,
+        TagColor | 638, TagColor | 532, TagColor | 460, TagVoid
+    };
+    return tags;
+}
+
+SampleFormat::SampleFormat(const QVector<quint16> & tags)
+{
+    for (quint16 tag : tags) {
+        if (tag == TagVoid) continue;
+        if (tag == TagPrecision16) {
+            if (!fields_.isEmpty()) fields_.last().size = 2;
+            continue;
+        }
+
+        Target target = Target::Skip;
+        if      (tag == TagX) target = Target::X;
+        else if (tag == TagY) target = Target::Y;
+        else if ((tag & TagColorMask) == TagColor) {
+            const int wavelength = tag & ~TagColorMask;
+            if      (wavelength >= 600) target = Target::R;
+            else if (wavelength >= 500) target = Target::G;
+            else if (wavelength >= 380) target = Target::B;
+        }
+        fields_ << Field{ .target = target, .size = 1 };
+    }
+
+    for (const Field & field : std::as_const(fields_)) sampleSize_ += field.size;
+}
+
+SampleFormat SampleFormat::parse(const quint8 * words, int wordCount)
+{
+    QVector<quint16> tags;
+    tags.reserve(wordCount * 2);
+    for (int i = 0 ; i < wordCount * 2 ; ++i) tags << read16(words + i * 2);
+    return SampleFormat(tags);
+}
+
+void SampleFormat::decode(const quint8 * data, int count, quint32 duration, EasyLase::Points & out, double & carry) const
+{
+    if (count <= 0) return;
+    const double perSample = Laser::MaxSpeed * (duration / 1e6) / count;
+    out.reserve(out.size() + qCeil(perSample * count) + 1);
+
+    for (int i = 0 ; i < count ; ++i) {
+        EasyLase::Point point;
+        const quint8 * p = data + i * sampleSize_;
+        for (const Field & field : fields_) {
+            switch (field.target) {
+                case Target::Skip:                                      break;
+                case Target::X:    point.x = toAxis(p, field.size);     break;
+                case Target::Y:    point.y = toAxis(p, field.size);     break;
+                case Target::R:    point.r = qMax(point.r, p[0]);       break;
+                case Target::G:    point.g = qMax(point.g, p[0]);       break;
+                case Target::B:    point.b = qMax(point.b, p[0]);       break;
+            }
+            p += field.size;
+        }
+
+        carry += perSample;
+        const int n = (int)carry;
+        carry -= n;
+        for (int j = 0 ; j < n ; ++j) out << point;
+    }
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <laser/easylase.h>
+
+// ILDA Digital Network: IDN-Hello packets carrying IDN-Stream channel messages over UDP.
+// All multi-byte values are big endian.
+namespace idn {
+
+constexpr quint16 Port = 7255;
+
+// IDN-Hello header: command, flags, sequence (16 bit)
+constexpr int HelloHeaderSize   = 4;
+// channel message header: total size (16 bit), content id (16 bit), timestamp (32 bit, us)
+constexpr int MessageHeaderSize = 8;
+// channel configuration: word count, flags, service id, service mode (followed by descriptors)
+constexpr int ConfigHeaderSize  = 4;
+// sample chunk header: flags, duration (24 bit, us)
+constexpr int ChunkHeaderSize   = 4;
+
+constexpr int MaxPacketSize     = 65507;
+constexpr int MaxPayloadSize    = 1454;  // keeps packets unfragmented on ethernet
+
+enum Command : quint8 {
+    PingRequest          = 0x08,
+    PingResponse         = 0x09,
+    ScanRequest          = 0x10,
+    ScanResponse         = 0x11,
+    ChannelMessage       = 0x40,
+    ChannelMessageAckReq = 0x41,
+    ChannelClose         = 0x44,
+    ChannelCloseAckReq   = 0x45,
+    ChannelAbort         = 0x46,
+    Acknowledge          = 0x47
+};
+
+// content id
+constexpr quint16 ContentChannelMessage = 0x8000;
+constexpr quint16 ContentConfig         = 0x4000;  // config follows, last fragment for sequel chunks
+constexpr quint16 ContentChannelMask    = 0x3F00;
+constexpr quint16 ContentChunkMask      = 0x00FF;
+
+// chunk types
+constexpr quint8 ChunkWave        = 0x01;  // continuous samples
+constexpr quint8 ChunkFrame       = 0x02;  // complete frame
+constexpr quint8 ChunkFrameFirst  = 0x03;  // first fragment of a frame
+constexpr quint8 ChunkFrameSequel = 0xC0;  // following fragments
+
+// channel configuration
+constexpr quint8 ConfigRouting  = 0x01;
+constexpr quint8 ConfigClose    = 0x02;
+constexpr quint8 ModeContinuous = 0x01;  // graphic service with wave chunks
+constexpr quint8 ModeDiscrete   = 0x02;  // graphic service with frame chunks
+
+// sample chunk flags
+constexpr quint8 FrameOnce = 0x01;
+
+// descriptor tags
+constexpr quint16 TagVoid        = 0x0000;
+constexpr quint16 TagPrecision16 = 0x4010;  // previous value has 16 bit
+constexpr quint16 TagX           = 0x4200;
+constexpr quint16 TagY           = 0x4210;
+constexpr quint16 TagColor       = 0x5000;  // | wavelength in nm
+constexpr quint16 TagColorMask   = 0xFC00;
+
+inline quint16 read16(const quint8 * p) { return p[0] << 8 | p[1]; }
+inline quint32 read24(const quint8 * p) { return p[0] << 16 | p[1] << 8 | p[2]; }
+inline quint32 read32(const quint8 * p) { return (quint32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]; }
+
+inline void append8 (QByteArray & ba, quint8  v) { ba.append((char)v); }
+inline void append16(QByteArray & ba, quint16 v) { append8(ba, v >> 8); append8(ba, v); }
+inline void append24(QByteArray & ba, quint32 v) { append8(ba, v >> 16); append16(ba, v); }
+inline void append32(QByteArray & ba, quint32 v) { append16(ba, v >> 16); append16(ba, v); }
+
+// Sample layout given by the descriptors of a channel configuration.
+// X, Y and colors of 8 or 16 bit are used, colors are assigned to r, g, b by wavelength.
+// All other values are skipped.
+class SampleFormat
+{
+public:
+    // XYRGB with 16 bit coordinates and 8 bit colors (638nm, 532nm, 460nm)
+    static const QVector<quint16> & defaultTags();
+
+    SampleFormat() = default;
+    SampleFormat(const QVector<quint16> & tags);
+
+    static SampleFormat parse(const quint8 * words, int wordCount);
+
+    bool isValid() const { return sampleSize_ > 0; }
+    int sampleSize() const { return sampleSize_; }
+
+    // Appends count samples from data, each one repeated to fill duration (us) at Laser::MaxSpeed.
+    // carry keeps the fraction of device points between calls.
+    void decode(const quint8 * data, int count, quint32 duration, EasyLase::Points & out, double & carry) const;
+
+private:
+    enum class Target : quint8 { Skip, X, Y, R, G, B };
+
+    struct Field
+    {
+        Target target;
+        int    size;  // bytes
+    };
+
+private:
+    QVector<Field> fields_;
+    int            sampleSize_ = 0;
+};
+
+}
@@ -0,0 +1,396 @@
+#include "idnreceiver.h"
+
+#include <laser/laser.h>
+
+#include <cflib/util/log.h>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+USE_LOG(LogCat::Network)
+
+using namespace idn;
+
+namespace {
+
+constexpr int    PollTimeout    = 10;       // ms, other calls wait at most that long
+constexpr qint64 SessionTimeout = 1000000;  // us without messages until a session ends
+constexpr int    ReceiveBuffer  = 4 * 1024 * 1024;
+constexpr qint64 MaxDuration    = (qint64)Laser::StreamRepeatLimit * 1000000 / Laser::MaxSpeed;  // us of one chunk
+
+inline bool isSameAddress(const sockaddr_in & a, const sockaddr_in & b)
+{
+    return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+}
+
+IdnReceiver::IdnReceiver(Laser & laser)
+:
+    ThreadVerify("IdnReceiver", Worker),
+    laser_(laser),
+    receiveTimer_(this, &IdnReceiver::receive),
+    buffer_(BatchSize * MaxPacketSize, 0)
+{
+    for (int i = 0 ; i < BatchSize ; ++i) {
+        iovs_[i] = iovec{ .iov_base = buffer_.data() + i * MaxPacketSize, .iov_len = MaxPacketSize };
+        msgs_[i] = mmsghdr{};
+        msgs_[i].msg_hdr.msg_name   = &addrs_[i];
+        msgs_[i].msg_hdr.msg_iov    = &iovs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+IdnReceiver::~IdnReceiver()
+{
+    stopVerifyThread();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool IdnReceiver::start(const Config & config)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&IdnReceiver::start, config)) return stc.retval();
+    logFunctionTrace
+
+    stop();
+    config_ = config;
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(config.port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (!config.address.isEmpty() && inet_pton(AF_INET, config.address.constData(), &addr.sin_addr) != 1) {
+        logWarn("invalid IDN address: %1", config.address);
+        return false;
+    }
+
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || bind(fd_, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+        logWarn("cannot bind IDN port %1: %2", config.port, strerror(errno));
+        stop();
+        return false;
+    }
+    // bursts of the sender have to fit into the kernel buffer
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &ReceiveBuffer, sizeof(ReceiveBuffer));
+
+    logInfo("receiving IDN on port %1 (jitter buffer: %2ms)", config.port, config.jitter);
+    receiveTimer_.singleShot(0);
+    return true;
+}
+
+void IdnReceiver::stop()
+{
+    if (!verifyThreadCall(&IdnReceiver::stop)) return;
+    logFunctionTrace
+
+    receiveTimer_.stop();
+    closeSession();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+IdnReceiver::Stats IdnReceiver::stats() const
+{
+    SyncedThreadCall<Stats> stc(this);
+    if (!stc.verify(&IdnReceiver::stats)) return stc.retval();
+    return stats_;
+}
+
+void IdnReceiver::receive()
+{
+    if (fd_ < 0) return;
+
+    pollfd pfd{ .fd = fd_, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, pollTimeout(Laser::now())) > 0) {
+        for (mmsghdr & msg : msgs_) msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        const int count = recvmmsg(fd_, msgs_, BatchSize, MSG_DONTWAIT, nullptr);
+        const qint64 time = Laser::now();
+        for (int i = 0 ; i < count ; ++i) {
+            if (msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                ++stats_.invalid;
+                continue;
+            }
+            handlePacket((const quint8 *)iovs_[i].iov_base, msgs_[i].msg_len, addrs_[i], time);
+        }
+    }
+
+    const qint64 time = Laser::now();
+    release(time);
+    if (isSession_ && time - lastArrival_ > SessionTimeout) {
+        logInfo("IDN session timed out");
+        closeSession();
+    }
+    receiveTimer_.singleShot(0);
+}
+
+void IdnReceiver::handlePacket(const quint8 * data, int size, const sockaddr_in & from, qint64 time)
+{
+    ++stats_.packets;
+    if (size < HelloHeaderSize) {
+        ++stats_.invalid;
+        return;
+    }
+    const quint8  command = data[0];
+    const quint16 seq     = read16(data + 2);
+
+    switch (command) {
+        case PingRequest:
+            reply(from, PingResponse, seq, QByteArray((const char *)data + HelloHeaderSize, size - HelloHeaderSize));
+            return;
+        case ScanRequest: {
+            QByteArray scan;
+            append8(scan, 40);    // struct size
+            append8(scan, 0x10);  // protocol version 1.0
+            append8(scan, 0x01);  // status: real-time streaming
+            append8(scan, 0);
+            scan.append(16, 0);   // unit id
+            scan.append(QByteArray("cflase").leftJustified(20, 0, true));
+            reply(from, ScanResponse, seq, scan);
+            return;
+        }
+        case ChannelMessage:
+        case ChannelMessageAckReq:
+        case ChannelClose:
+        case ChannelCloseAckReq:
+        case ChannelAbort:
+            break;
+        default:
+            ++stats_.invalid;
+            return;
+    }
+
+    // one sender at a time
+    if (!isSession_) {
+        logInfo("IDN session of %1:%2 started", inet_ntoa(from.sin_addr), ntohs(from.sin_port));
+        isSession_ = true;
+        peer_      = from;
+        lastSeq_   = seq;
+    } else if (!isSameAddress(from, peer_)) {
+        logDebug("ignoring IDN packet of %1 during active session", inet_ntoa(from.sin_addr));
+        return;
+    }
+
+    // sequence numbers extended to 64 bit
+    const qint64 ext = lastSeq_ + (qint16)(quint16)(seq - (quint16)lastSeq_);
+    lastSeq_     = qMax(lastSeq_, ext);
+    lastArrival_ = time;
+
+    if (command == ChannelMessageAckReq || command == ChannelCloseAckReq) {
+        QByteArray ack;
+        append8 (ack, 4);  // struct size
+        append8 (ack, 0);  // result: ok
+        append16(ack, 0);  // input event flags
+        reply(from, Acknowledge, seq, ack);
+    }
+    if (command == ChannelAbort) {
+        closeSession();
+        return;
+    }
+    if (size > HelloHeaderSize) handleMessage(data + HelloHeaderSize, size - HelloHeaderSize, ext, time);
+    if (command == ChannelClose || command == ChannelCloseAckReq) closeSession();
+}
+
+void IdnReceiver::handleMessage(const quint8 * data, int size, qint64 seq, qint64 time)
+{
+    const int     total     = size >= MessageHeaderSize ? qMin<int>(read16(data), size) : 0;
+    const quint16 contentId = total >= MessageHeaderSize ? read16(data + 2) : 0;
+    if (!(contentId & ContentChannelMessage)) {
+        ++stats_.invalid;
+        return;
+    }
+
+    // every message takes its place in the jitter buffer, so that gaps can be detected
+    if ((nextSeq_ >= 0 && seq < nextSeq_) || pending_.contains(seq)) {
+        ++stats_.late;
+        return;
+    }
+    Chunk & chunk = pending_[seq];
+    chunk.arrival  = time;
+    chunk.duration = 0;
+
+    const int    channel = (contentId & ContentChannelMask) >> 8;
+    const quint8 type    = contentId & ContentChunkMask;
+    if (channel_ >= 0 && channel != channel_) {
+        logDebug("ignoring IDN channel %1, using %2", channel, channel_);
+        return;
+    }
+    channel_ = channel;
+
+    int  pos     = MessageHeaderSize;
+    bool isClose = false;
+    if (type != ChunkFrameSequel && (contentId & ContentConfig)) {
+        const int words = total >= pos + ConfigHeaderSize ? data[pos] : 0;
+        if (total < pos + ConfigHeaderSize + words * 4) {
+            ++stats_.invalid;
+            return;
+        }
+        format_ = SampleFormat::parse(data + pos + ConfigHeaderSize, words);
+        mode_   = data[pos + 3];
+        isClose = data[pos + 1] & ConfigClose;
+        pos += ConfigHeaderSize + words * 4;
+    }
+
+    if (type == ChunkWave) {
+        if (mode_ != ModeContinuous || !format_.isValid() || total < pos + ChunkHeaderSize ||
+            read24(data + pos + 1) > MaxDuration) {
+            ++stats_.invalid;
+        } else {
+            chunk.duration = read24(data + pos + 1);
+            const int count = (total - pos - ChunkHeaderSize) / format_.sampleSize();
+            format_.decode(data + pos + ChunkHeaderSize, count, chunk.duration, chunk.points, carry_);
+        }
+    } else if (type == ChunkFrame || type == ChunkFrameFirst || type == ChunkFrameSequel) {
+        if (mode_ != ModeDiscrete || !format_.isValid()) ++stats_.invalid;
+        else handleFrame(type, data + pos, total - pos, contentId & ContentConfig, seq);
+    }
+
+    if (isClose) closeSession();
+}
+
+void IdnReceiver::handleFrame(quint8 type, const quint8 * data, int size, bool isLast, qint64 seq)
+{
+    // fragments are collected in order, a missing one drops the frame
+    if (type == ChunkFrameFirst) {
+        fragments_   = QByteArray((const char *)data, size);
+        fragmentSeq_ = seq;
+        return;
+    }
+    if (type == ChunkFrameSequel) {
+        if (fragmentSeq_ < 0 || seq != fragmentSeq_ + 1) {
+            fragments_.clear();
+            fragmentSeq_ = -1;
+            return;
+        }
+        // more samples than device points could be shown
+        if (fragments_.size() + size > ChunkHeaderSize + (qint64)Laser::StreamRepeatLimit * format_.sampleSize()) {
+            ++stats_.invalid;
+            fragments_.clear();
+            fragmentSeq_ = -1;
+            return;
+        }
+        fragments_.append((const char *)data, size);
+        fragmentSeq_ = seq;
+        if (!isLast) return;
+        data = (const quint8 *)fragments_.constData();
+        size = fragments_.size();
+    }
+
+    if (size < ChunkHeaderSize || read24(data + 1) > MaxDuration) {
+        ++stats_.invalid;
+        fragments_.clear();
+        fragmentSeq_ = -1;
+        return;
+    }
+    if (seq <= frameSeq_) {
+        ++stats_.late;
+        return;
+    }
+    frameSeq_ = seq;
+
+    const bool    isOnce   = data[0] & FrameOnce;
+    const quint32 duration = read24(data + 1);
+    const int     count    = (size - ChunkHeaderSize) / format_.sampleSize();
+    EasyLase::Points points;
+    double carry = 0.0;
+    format_.decode(data + ChunkHeaderSize, count, duration, points, carry);
+    fragments_.clear();
+    fragmentSeq_ = -1;
+    if (points.isEmpty()) return;
+
+    // replaces a running wave stream
+    isStreaming_    = false;
+    isPrebuffering_ = true;
+    ++stats_.frames;
+    laser_.showConverted(points, !isOnce);
+}
+
+void IdnReceiver::reply(const sockaddr_in & to, quint8 command, quint16 seq, const QByteArray & payload)
+{
+    QByteArray packet;
+    packet.reserve(HelloHeaderSize + payload.size());
+    append8 (packet, command);
+    append8 (packet, 0);
+    append16(packet, seq);
+    packet.append(payload);
+    if (sendto(fd_, packet.constData(), packet.size(), MSG_DONTWAIT, (const sockaddr *)&to, sizeof(to)) < 0) {
+        logDebug("cannot reply to IDN client: %1", strerror(errno));
+    }
+}
+
+void IdnReceiver::release(qint64 time, bool flush)
+{
+    const qint64 jitter = config_.jitter * 1000;
+
+    if (!flush) {
+        if (isStreaming_ && !isPrebuffering_ && time > playEnd_) {
+            logDebug("IDN stream ran dry, buffering again");
+            ++stats_.underruns;
+            isPrebuffering_ = true;
+        }
+        if (isPrebuffering_) {
+            qint64 buffered = 0;
+            for (const Chunk & chunk : std::as_const(pending_)) buffered += chunk.duration;
+            if (buffered < jitter && (pending_.isEmpty() || time < pending_.first().arrival + jitter)) return;
+            isPrebuffering_ = false;
+        }
+    }
+
+    while (!pending_.isEmpty()) {
+        const qint64 seq = pending_.firstKey();
+        if (nextSeq_ >= 0 && seq != nextSeq_) {
+            // missing packets may still arrive
+            if (!flush && time < pending_.first().arrival + jitter) break;
+            logTrace("IDN packets lost: %1", seq - nextSeq_);
+            stats_.lost += seq - nextSeq_;
+        }
+        nextSeq_ = seq + 1;
+
+        const Chunk chunk = pending_.take(seq);
+        if (chunk.points.isEmpty()) continue;
+        if (!isStreaming_) {
+            laser_.beginStream();
+            isStreaming_ = true;
+            playEnd_     = time;
+        }
+        if (laser_.appendConvertedStream(chunk.points)) {
+            ++stats_.chunks;
+            playEnd_ = qMax(playEnd_, time) + chunk.duration;
+        } else {
+            ++stats_.overflows;
+        }
+    }
+}
+
+void IdnReceiver::closeSession()
+{
+    if (!isSession_) return;
+    logInfo("IDN session ended");
+
+    release(Laser::now(), true);
+    if (isStreaming_) laser_.endStream(false);
+
+    isSession_      = false;
+    channel_        = -1;
+    lastSeq_        = -1;
+    format_         = SampleFormat();
+    mode_           = 0;
+    carry_          = 0.0;
+    pending_.clear();
+    nextSeq_        = -1;
+    isPrebuffering_ = true;
+    isStreaming_    = false;
+    fragments_.clear();
+    fragmentSeq_    = -1;
+    frameSeq_       = -1;
+}
+
+int IdnReceiver::pollTimeout(qint64 time) const
+{
+    if (pending_.isEmpty()) return PollTimeout;
+    const qint64 wait = pending_.first().arrival + config_.jitter * 1000 - time;
+    return qBound<qint64>(0, (wait + 999) / 1000, PollTimeout);
+}
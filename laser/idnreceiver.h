@@ -0,0 +1,103 @@
+#pragma once
+
+#include <laser/idn.h>
+
+#include <cflib/util/evtimer.h>
+#include <cflib/util/threadverify.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+class Laser;
+
+// Receives one IDN stream over UDP and feeds it into Laser.
+// Wave chunks are played as stream after a jitter buffer, frames replace the shown content.
+// Datagrams are fetched in batches and decoded right out of the receive buffers.
+// Hello pings, scans and acknowledge requests are answered.
+class IdnReceiver : private cflib::util::ThreadVerify
+{
+public:
+    struct Config
+    {
+        QByteArray address;          // to bind to, empty -> any
+        quint16    port   = idn::Port;
+        int        jitter = 20;      // ms of wave content buffered and waited for missing packets
+    };
+
+    struct Stats
+    {
+        quint64 packets   = 0;
+        quint64 invalid   = 0;
+        quint64 lost      = 0;  // missing sequence numbers
+        quint64 late      = 0;  // arrived after being skipped, or duplicates
+        quint64 chunks    = 0;  // wave chunks passed to Laser
+        quint64 overflows = 0;  // wave chunks rejected by Laser, sender is faster than the device
+        quint64 underruns = 0;
+        quint64 frames    = 0;
+    };
+
+public:
+    IdnReceiver(Laser & laser);
+    ~IdnReceiver();
+
+    bool start(const Config & config);
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Chunk
+    {
+        qint64           arrival;   // us
+        qint64           duration;  // us
+        EasyLase::Points points;    // empty for messages without wave content
+    };
+
+    static constexpr int BatchSize = 16;
+
+private:
+    void receive();
+    void handlePacket(const quint8 * data, int size, const sockaddr_in & from, qint64 time);
+    void handleMessage(const quint8 * data, int size, qint64 seq, qint64 time);
+    void handleFrame(quint8 type, const quint8 * data, int size, bool isLast, qint64 seq);
+    void reply(const sockaddr_in & to, quint8 command, quint16 seq, const QByteArray & payload);
+    void release(qint64 time, bool flush = false);
+    void closeSession();
+    int pollTimeout(qint64 time) const;
+
+private:
+    Laser &              laser_;
+    Config               config_;
+    int                  fd_ = -1;
+    cflib::util::EVTimer receiveTimer_;
+    Stats                stats_;
+
+    QByteArray           buffer_;
+    mmsghdr              msgs_[BatchSize];
+    iovec                iovs_[BatchSize];
+    sockaddr_in          addrs_[BatchSize];
+
+    // session: one sender and channel at a time
+    bool                 isSession_ = false;
+    sockaddr_in          peer_;
+    int                  channel_ = -1;
+    qint64               lastSeq_ = -1;   // extended to 64 bit
+    qint64               lastArrival_ = 0;
+    idn::SampleFormat    format_;
+    quint8               mode_ = 0;
+    double               carry_ = 0.0;    // fraction of device points between wave chunks
+
+    // jitter buffer
+    QMap<qint64, Chunk>  pending_;
+    qint64               nextSeq_ = -1;
+    bool                 isPrebuffering_ = true;
+    bool                 isStreaming_ = false;
+    qint64               playEnd_ = 0;    // us, predicted end of content passed to Laser
+
+    // fragmented frame
+    QByteArray           fragments_;
+    quint8               fragmentFlags_ = 0;
+    quint32              fragmentDuration_ = 0;
+    qint64               fragmentSeq_ = -1;
+    qint64               frameSeq_ = -1;
+};
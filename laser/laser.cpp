@@ -1,13 +1,64 @@
 #include "laser.h"
 
+#include <laser/blanking.h>
+
 #include <cflib/util/log.h>
 
+#include <chrono>
+
 using namespace cflib::util;
 
 USE_LOG(LogCat::Etc)
 
 namespace {
 
+constexpr double    PollInterval    = 0.002;  // seconds between device ready checks
+constexpr int       LookAheadFrames = 3;      // converted one-shot frames kept ahead of the device
+constexpr qsizetype CompactSize     = 65536;  // consumed source points before releasing memory
+constexpr qsizetype ParallelSize    = 4 * EasyLase::MaxPoints;  // larger shows get converted on the pool
+constexpr int       ChunksAhead     = 8;      // one-shot frames converted ahead on the pool
+constexpr qint64    CueSpin         = 200;    // us busy waiting before a cue, timers are not that exact
+constexpr qint64    FinishedSlack   = 2000;   // us the finished callback may be early
+constexpr int       MinReconnect    = 5;      // ms backoff after the first failed reconnect
+constexpr int       MaxReconnect    = 2000;   // ms
+
+// cue points of shown points -> device points
+// Exact for unprepared content only, with resampling, path optimization or level of detail
+// the cue is moved proportionally and may fire at another stroke.
+Laser::Cues deviceCues(const Laser::Cues & cues, qsizetype inputSize, qsizetype shownSize, int replication)
+{
+    const double scale = inputSize > 0 ? (double)shownSize / inputSize * replication : replication;
+    Laser::Cues rv = cues;
+    for (Laser::Cue & cue : rv) cue.point = qRound64(cue.point * scale);
+    return rv;
+}
+
+size_t hashContent(const Laser::Points & points, quint16 pps, bool repeat, double targetRate)
+{
+    const qsizetype n = points.size();
+    size_t rv = qHashMulti(0, n, pps, Laser::replication(pps), repeat, targetRate);
+    rv = qHashBits(points.xData(), n * sizeof(qint16), rv);
+    rv = qHashBits(points.yData(), n * sizeof(qint16), rv);
+    rv = qHashBits(points.rData(), n, rv);
+    rv = qHashBits(points.gData(), n, rv);
+    return qHashBits(points.bData(), n, rv);
+}
+
+bool isSame(const Laser::Points & a, const Laser::Points & b)
+{
+    const qsizetype n = a.size();
+    return n == b.size() &&
+        memcmp(a.xData(), b.xData(), n * sizeof(qint16)) == 0 && memcmp(a.yData(), b.yData(), n * sizeof(qint16)) == 0 &&
+        memcmp(a.rData(), b.rData(), n) == 0 && memcmp(a.gData(), b.gData(), n) == 0 && memcmp(a.bData(), b.bData(), n) == 0;
+}
+
+bool isSame(const Laser::Cues & a, const Laser::Cues & b)
+{
+    if (a.size() != b.size()) return false;
+    for (qsizetype i = 0 ; i < a.size() ; ++i) if (a[i].point != b[i].point || a[i].ttl != b[i].ttl) return false;
+    return true;
+}
+
 inline quint16 convertAxis(double v) { return qMax(0, qMin(4095, qRound((v + 1.0) * 2047.5))); }
 
 inline EasyLase::Point convertPoint(const Laser::Point & p)
@@ -26,15 +77,26 @@ inline EasyLase::Point convertPoint(const Laser::Point & p)
 Laser::Laser()
 :
     ThreadVerify("Laser", Worker),
-    readyTimer_(this, &Laser::checkEasyLaseReady)
+    reconnectTimer_(this, &Laser::reconnect),
+    deviceWatcher_([this]() { deviceAdded(); }),
+    readyTimer_(this, &Laser::checkEasyLaseReady),
+    finishedTimer_(this, &Laser::callFinished),
+    deviceClock_(MaxSpeed),
+    timedTimer_(this, &Laser::activateTimed),
+    cueTimer_(this, &Laser::fireCues)
 {
     setThreadPrio(QThread::TimeCriticalPriority);
     easyLase_.setErrorCallback([this]() { easyLaseError(); });
+    // one core stays with the time-critical device thread
+    pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
 }
 
 Laser::~Laser()
 {
     idle();
+    pool_.clear();
+    pool_.waitForDone();
+    deviceWatcher_.stop();
     stopVerifyThread();
 }
 
@@ -44,6 +106,8 @@ void Laser::reset()
     hasError_ = false;
     error_    = QString();
     easyLase_.connect();
+    // manual reset during recovery
+    if (isRecovering_ && !endRecovery()) hasError_ = true;
     idle();
 }
 
@@ -75,11 +139,28 @@ void Laser::setActiveCallback(BoolFunc callback)
     activeCallback_ = callback;
 }
 
-void Laser::setFinishedCallback(VoidFunc callback)
+void Laser::setFinishedCallback(FinishFunc callback, int leadTime)
 {
-    if (!verifyThreadCall(&Laser::setFinishedCallback, callback)) return;
+    if (!verifyThreadCall(&Laser::setFinishedCallback, callback, leadTime)) return;
     logFunctionTrace
     finishedCallback_ = callback;
+    finishedLead_     = qMax(0, leadTime);
+    if (!finishedCallback_) isFinishedArmed_ = false;
+    scheduleFinished();
+}
+
+void Laser::setPresentedCallback(TimeFunc callback)
+{
+    if (!verifyThreadCall(&Laser::setPresentedCallback, callback)) return;
+    logFunctionTrace
+    presentedCallback_ = callback;
+}
+
+void Laser::setCueCallback(CueFunc callback)
+{
+    if (!verifyThreadCall(&Laser::setCueCallback, callback)) return;
+    logFunctionTrace
+    cueCallback_ = callback;
 }
 
 void Laser::waitForFinish()
@@ -88,122 +169,935 @@ void Laser::waitForFinish()
     logFunctionTrace
 }
 
-void Laser::on()
+void Laser::on(BoolFunc done)
 {
-    if (!verifyThreadCall(&Laser::on)) return;
+    if (!verifyThreadCall(&Laser::on, done)) return;
     logFunctionTrace
     easyLase_.setTTL(0x03);
+    if (done) done(!hasError_);
 }
 
-void Laser::off()
+void Laser::off(BoolFunc done)
 {
-    if (!verifyThreadCall(&Laser::off)) return;
+    if (!verifyThreadCall(&Laser::off, done)) return;
     logFunctionTrace
     easyLase_.setTTL(0x00);
+    if (done) done(!hasError_);
+}
+
+bool Laser::setRealtime(const realtime::Config & config)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Laser::setRealtime, config)) return stc.retval();
+    logFunctionTrace
+    return realtime::applyToCurrentThread(config);
+}
+
+dao::TimerStats Laser::timerStats() const
+{
+    SyncedThreadCall<dao::TimerStats> stc(this);
+    if (!stc.verify(&Laser::timerStats)) return stc.retval();
+    return timerStats_;
+}
+
+void Laser::resetTimerStats()
+{
+    if (!verifyThreadCall(&Laser::resetTimerStats)) return;
+    logFunctionTrace
+    timerStats_ = dao::TimerStats();
+}
+
+dao::ContentCacheStats Laser::contentCacheStats() const
+{
+    SyncedThreadCall<dao::ContentCacheStats> stc(this);
+    if (!stc.verify(&Laser::contentCacheStats)) return stc.retval();
+    dao::ContentCacheStats rv = contentCacheStats_;
+    rv.entries = contentCache_.size();
+    return rv;
+}
+
+dao::LevelOfDetailStats Laser::levelOfDetailStats() const
+{
+    SyncedThreadCall<dao::LevelOfDetailStats> stc(this);
+    if (!stc.verify(&Laser::levelOfDetailStats)) return stc.retval();
+    return lodStats_;
+}
+
+dao::RecoveryStats Laser::recoveryStats() const
+{
+    SyncedThreadCall<dao::RecoveryStats> stc(this);
+    if (!stc.verify(&Laser::recoveryStats)) return stc.retval();
+    dao::RecoveryStats rv = recoveryStats_;
+    rv.isRecovering = isRecovering_;
+    return rv;
+}
+
+int Laser::addFrameSink(std::shared_ptr<FrameSink> sink, const FrameFanout::Config & config)
+{
+    SyncedThreadCall<int> stc(this);
+    if (!stc.verify(&Laser::addFrameSink, sink, config)) return stc.retval();
+    logFunctionTrace
+    return fanout_.add(sink, config);
+}
+
+void Laser::removeFrameSink(int id)
+{
+    if (!verifySyncedThreadCall(&Laser::removeFrameSink, id)) return;
+    logFunctionTrace
+    fanout_.remove(id);
+}
+
+FrameFanout::Stats Laser::frameSinkStats(int id) const
+{
+    SyncedThreadCall<FrameFanout::Stats> stc(this);
+    if (!stc.verify(&Laser::frameSinkStats, id)) return stc.retval();
+    return fanout_.stats(id);
+}
+
+void Laser::setPathOptimizer(const PathOptimizer::Config & config)
+{
+    if (!verifyThreadCall(&Laser::setPathOptimizer, config)) return;
+    logFunctionTrace
+    pathOptimizer_ = PathOptimizer(config);
+    clearContentCache();
+}
+
+void Laser::setResampler(const Resampler::Config & config)
+{
+    if (!verifyThreadCall(&Laser::setResampler, config)) return;
+    logFunctionTrace
+    resampler_ = Resampler(config);
+    clearContentCache();
+}
+
+void Laser::setLevelOfDetail(const LevelOfDetail::Config & config)
+{
+    if (!verifyThreadCall(&Laser::setLevelOfDetail, config)) return;
+    logFunctionTrace
+    levelOfDetail_ = LevelOfDetail(config);
+    clearContentCache();
+}
+
+void Laser::setOutputCorrection(const OutputCorrection & correction)
+{
+    if (!verifyThreadCall(&Laser::setOutputCorrection, correction)) return;
+    logFunctionTrace
+    outputCorrection_ = correction;
+    clearContentCache();
+}
+
+void Laser::setSeamlessSwitching(bool seamless, bool blankedTransition)
+{
+    if (!verifyThreadCall(&Laser::setSeamlessSwitching, seamless, blankedTransition)) return;
+    logFunctionTrace
+    isSeamless_      = seamless;
+    isBlankedSwitch_ = blankedTransition;
+}
+
+double Laser::switchLatency() const
+{
+    SyncedThreadCall<double> stc(this);
+    if (!stc.verify(&Laser::switchLatency)) return stc.retval();
+    return switchLatency_;
+}
+
+void Laser::idle(BoolFunc done)
+{
+    if (!verifyThreadCall(&Laser::idle, done)) return;
+    logFunctionTrace
+    resetStream();
+    timed_.clear();
+    isTimedDue_ = false;
+    stop();
+    if (done) done(!hasError_);
+}
+
+void Laser::show(const Points & input, bool repeat, quint16 pps, const Cues & cues, double targetRate)
+{
+    if (!verifyThreadCall(&Laser::show, input, repeat, pps, cues, targetRate)) return;
+    logFunctionTrace
+    resetStream();
+
+    // empty input
+    if (input.isEmpty() || pps == 0) {
+        stop();
+        return;
+    }
+
+    // the target rate only matters for repeated content
+    if (!repeat) targetRate = 0.0;
+
+    const size_t hash = hashContent(input, pps, repeat, targetRate);
+    if (const CachedContent * content = findContent(hash, input, pps, repeat, targetRate)) {
+        if (targetRate > 0.0) lodStats_ = content->lod;
+        const Cues dCues = deviceCues(cues, input.size(), content->shownSize, replication(pps));
+        if (repeat && content->id == playingContent_ && isSame(dCues, cues_) && !isSwitching_ && timed_.isEmpty()) {
+            ++contentCacheStats_.unchanged;
+            logTrace("content is playing already");
+            return;
+        }
+        logDebug("showing %1 cached device points %2 repeat", content->devicePoints.size(), repeat ? "with" : "without");
+        const quint64          id           = content->id;
+        const EasyLase::Points devicePoints = content->devicePoints;
+        if (!repeat) {
+            enqueueOnce(Source{ .devicePoints = devicePoints, .cues = dCues });
+            return;
+        }
+        enqueueRepeat(devicePoints, dCues);
+        playingContent_ = id;
+        return;
+    }
+
+    dao::LevelOfDetailStats lod;
+    const Points    points = prepare(input, repeat, pps, targetRate, &lod);
+    const Cues      dCues  = deviceCues(cues, input.size(), points.size(), replication(pps));
+    const qsizetype size   = points.size() * replication(pps);
+    CachedContent content{
+        .hash       = hash,
+        .input      = input,
+        .pps        = pps,
+        .repeat     = repeat,
+        .targetRate = targetRate,
+        .shownSize  = points.size(),
+        .lod        = lod,
+        .id         = 0
+    };
+    if (targetRate > 0.0) lodStats_ = lod;
+
+    logDebug("showing %1 points %2 repeat and %3 pps (replication: %4)",
+        points.size(), repeat ? "with" : "without", pps, replication(pps));
+
+    if (size > ParallelSize) {
+        // cached when its conversion is done
+        if (repeat) {
+            repeatContent_ = size <= ContentCacheLimit ? content : CachedContent();
+            convertRepeat(points, pps, dCues);
+        } else {
+            // one-shot content gets converted just ahead of the device
+            enqueueOnce(Source{ .points = points, .pps = pps, .cues = dCues });
+        }
+        return;
+    }
+
+    content.devicePoints = outputCorrection_.convert(points, pps);
+    const quint64 id = cacheContent(content);
+    if (repeat) {
+        enqueueRepeat(content.devicePoints, dCues);
+        playingContent_ = id;
+    } else {
+        enqueueOnce(Source{ .devicePoints = content.devicePoints, .cues = dCues });
+    }
+}
+
+void Laser::showConverted(const EasyLase::Points & points, bool repeat)
+{
+    if (!verifyThreadCall(&Laser::showConverted, points, repeat)) return;
+    logFunctionTrace
+    resetStream();
+
+    if (points.isEmpty()) {
+        stop();
+        return;
+    }
+    if (repeat) enqueueRepeat(outputCorrection_.correct(points));
+    else        enqueueOnce(Source{ .devicePoints = outputCorrection_.correct(points) });
+}
+
+void Laser::showRing(std::shared_ptr<ShmRing> ring)
+{
+    if (!verifyThreadCall(&Laser::showRing, ring)) return;
+    logFunctionTrace
+
+    // wake up
+    if (ring == ring_) {
+        expectedCheck_ = -1;
+        if (ring_) checkEasyLaseReady();
+        return;
+    }
+    if (!ring || ring->isClosed()) return;
+
+    logDebug("showing shared memory ring with %1 slots", ring->slotCount());
+    resetStream();
+    beginContent(true);
+    isRepeating_ = false;
+    ring_ = ring;
+    checkEasyLaseReady();
+    scheduleTimed();
+}
+
+void Laser::showAt(qint64 time, const Points & input, bool repeat, quint16 pps, const Cues & cues)
+{
+    if (!verifyThreadCall(&Laser::showAt, time, input, repeat, pps, cues)) return;
+    logFunctionTrace
+
+    if (input.isEmpty() || pps == 0) return;
+
+    // converted right away, so that it is ready in time
+    const Points points = prepare(input, repeat, pps);
+    const Timed timed{
+        .time   = time,
+        .points = outputCorrection_.convert(points, pps),
+        .repeat = repeat,
+        .cues   = deviceCues(cues, input.size(), points.size(), replication(pps))
+    };
+    auto it = timed_.begin();
+    while (it != timed_.end() && it->time <= time) ++it;
+    timed_.insert(it, timed);
+
+    logDebug("timed content with %1 points in %2ms", timed.points.size(), (time - now()) / 1000);
+    scheduleTimed();
+}
+
+qint64 Laser::now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+double Laser::devicePps() const
+{
+    SyncedThreadCall<double> stc(this);
+    if (!stc.verify(&Laser::devicePps)) return stc.retval();
+    return deviceClock_.pps();
+}
+
+void Laser::beginStream(quint16 pps)
+{
+    if (!verifyThreadCall(&Laser::beginStream, pps)) return;
+    logFunctionTrace
+    resetStream();
+
+    if (pps == 0) {
+        stop();
+        return;
+    }
+
+    logDebug("beginning stream with %1 pps", pps);
+    isStreaming_      = true;
+    streamPps_        = pps;
+    isStreamRecorded_ = true;
 }
 
-void Laser::idle()
+bool Laser::appendStream(const Points & points)
 {
-    if (!verifyThreadCall(&Laser::idle)) return;
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Laser::appendStream, points)) return stc.retval();
     logFunctionTrace
 
+    if (!isStreaming_) {
+        logWarn("cannot append %1 points without active stream", points.size());
+        return false;
+    }
+    if (points.isEmpty()) return true;
+
+    if (isStreamFull(points.size() * replication(streamPps_))) return false;
+
+    if (isStreamRecorded_) {
+        if ((streamRecord_.size() + points.size()) * replication(streamPps_) <= StreamRepeatLimit) {
+            streamRecord_ << points;
+        } else {
+            streamRecord_.clear();
+            isStreamRecorded_ = false;
+        }
+    }
+
+    enqueueOnce(Source{ .points = points, .pps = streamPps_ });
+    return true;
+}
+
+bool Laser::appendConvertedStream(const EasyLase::Points & points)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Laser::appendConvertedStream, points)) return stc.retval();
+    logFunctionTrace
+
+    if (!isStreaming_) {
+        logWarn("cannot append %1 points without active stream", points.size());
+        return false;
+    }
+    if (points.isEmpty()) return true;
+    if (isStreamFull(points.size())) return false;
+
+    streamRecord_.clear();
+    isStreamRecorded_ = false;
+    enqueueOnce(Source{ .devicePoints = outputCorrection_.correct(points) });
+    return true;
+}
+
+void Laser::endStream(bool repeat)
+{
+    if (!verifyThreadCall(&Laser::endStream, repeat)) return;
+    logFunctionTrace
+
+    if (!isStreaming_) return;
+    const Points record = streamRecord_;
+    const quint16 pps = streamPps_;
+    const bool isRecorded = isStreamRecorded_;
+    resetStream();
+
+    if (!repeat) return;
+    if (!isRecorded) {
+        logWarn("stream is too long to be repeated, showing it once");
+        return;
+    }
+    if (record.isEmpty()) return;
+    repeatAfterStream(outputCorrection_.convert(record, pps));
+}
+
+void Laser::endConvertedStream(const EasyLase::Points & points)
+{
+    if (!verifyThreadCall(&Laser::endConvertedStream, points)) return;
+    logFunctionTrace
+
+    if (!isStreaming_) return;
+    resetStream();
+    if (!points.isEmpty()) repeatAfterStream(outputCorrection_.correct(points));
+}
+
+void Laser::repeatAfterStream(const EasyLase::Points & points)
+{
+    // the loop starts after the last streamed block
+    if (!isActive_ || (pointQueue_.isEmpty() && sources_.isEmpty())) {
+        enqueueRepeat(points);
+        return;
+    }
+    if (hasPlaceholder_) {
+        pointQueue_.removeLast();
+        hasPlaceholder_ = false;
+    }
+    needsPlaceholder_ = false;
+    isFinishedArmed_ = false;
+    pendingRepeat_ = points;
+}
+
+EasyLase::Points Laser::convert(const dao::LaserPoints & points, quint16 pps)
+{
+    const int count = replication(pps);
+    EasyLase::Points rv;
+    rv.reserve(points.size() * count);
+    for (const Point & p : points) {
+        const EasyLase::Point ep = convertPoint(p);
+        for (int i = 0 ; i < count ; ++i) rv << ep;
+    }
+    return rv;
+}
+
+EasyLase::Point Laser::convert(const Point & point)
+{
+    return convertPoint(point);
+}
+
+int Laser::replication(quint16 pps)
+{
+    return qMax(1, qRound((double)MaxSpeed / (double)qMax<quint16>(1, pps)));
+}
+
+const Laser::CachedContent * Laser::findContent(size_t hash, const Points & input, quint16 pps, bool repeat,
+    double targetRate)
+{
+    for (qsizetype i = 0 ; i < contentCache_.size() ; ++i) {
+        const CachedContent & c = contentCache_[i];
+        if (c.hash != hash || c.pps != pps || c.repeat != repeat || c.targetRate != targetRate) continue;
+        if (!isSame(c.input, input)) continue;
+        ++contentCacheStats_.hits;
+        if (i > 0) contentCache_.move(i, 0);
+        return &contentCache_.first();
+    }
+    ++contentCacheStats_.misses;
+    return nullptr;
+}
+
+quint64 Laser::cacheContent(CachedContent content)
+{
+    if (content.devicePoints.size() > ContentCacheLimit) return 0;
+    content.id = ++lastContentId_;
+    contentCache_.prepend(content);
+    while (contentCache_.size() > ContentCacheSize) contentCache_.removeLast();
+    return content.id;
+}
+
+void Laser::clearContentCache()
+{
+    // the playing content is not what a new conversion would give
+    contentCache_.clear();
+    repeatContent_ = CachedContent();
+    playingContent_ = 0;
+}
+
+Laser::Points Laser::prepare(const Points & input, bool repeat, quint16 pps, double targetRate,
+    dao::LevelOfDetailStats * lod) const
+{
+    const bool isLimited   = repeat && targetRate > 0.0;
+    const bool isOptimized = repeat && pathOptimizer_.isEnabled();
+    const bool isResampled = repeat && resampler_.isEnabled();
+    if (!isResampled && !isOptimized && !isLimited) return input;
+
+    // all work on the wire format, the budget of the resampler is for one frame
+    dao::LaserPoints points = input.toLaserPoints();
+    double error       = 0.0;
+    int    droppedRuns = 0;
+    if (isLimited) {
+        // Geometry is simplified first, the resampler gives lines their interpolation points back
+        // and the path optimizer adds what the galvos need. Its part of the budget is estimated from the input.
+        const int       budget     = qMax(1, (int)(MaxSpeed / (targetRate * replication(pps))));
+        const qsizetype overhead   = isOptimized ? pathOptimizer_.optimize(points, pps, true).size() - points.size() : 0;
+        int             lineBudget = qMax<qsizetype>(1, budget - overhead);
+        const LevelOfDetail::Result result = levelOfDetail_.simplify(points, lineBudget);
+        error       = result.error;
+        droppedRuns = result.droppedRuns;
+        // only reduced dwell is shown as it is
+        if (error == 0.0 && droppedRuns == 0 && !isResampled) {
+            points = result.points;
+            if (isOptimized) points = pathOptimizer_.optimize(points, pps, true);
+        } else {
+            auto fit = [&]() {
+                Resampler::Config config = resampler_.config();
+                config.pointBudget = isResampled ? qMin(config.pointBudget, lineBudget) : lineBudget;
+                const dao::LaserPoints resampled = Resampler(config).resample(result.points);
+                return isOptimized ? pathOptimizer_.optimize(resampled, pps, true) : resampled;
+            };
+            points = fit();
+            // once more with the overhead of the simplified frame
+            if (isOptimized && points.size() != budget) {
+                lineBudget = qMax<qsizetype>(1, lineBudget + budget - points.size());
+                points = fit();
+            }
+        }
+    } else {
+        if (isResampled) points = resampler_.resample(points);
+        // one-shot content may be an animation, its strokes must not move to other frames
+        if (isOptimized) points = pathOptimizer_.optimize(points, pps, true);
+    }
+
+    if (isLimited && lod) {
+        lod->targetRate   = targetRate;
+        lod->achievedRate = points.isEmpty() ? 0.0 : (double)MaxSpeed / (points.size() * replication(pps));
+        lod->error        = error;
+        lod->inputPoints  = input.size();
+        lod->shownPoints  = points.size();
+        lod->droppedRuns  = droppedRuns;
+        if (lod->achievedRate < targetRate) {
+            logDebug("%1 points refresh at %2Hz only", input.size(), lod->achievedRate);
+        }
+    }
+    return points;
+}
+
+void Laser::stop()
+{
     bool doCallActiveCallback = false;
     if (isActive_) {
         logDebug("going idle");
         if (activeCallback_) doCallActiveCallback = true;
     }
 
+    if (isActive_ && !fanout_.isEmpty()) deliverFrame(now(), EasyLase::Points());
     isActive_ = false;
+    isSwitching_ = false;
+    ring_.reset();
+    playingContent_ = 0;
+    repeatJob_ = 0;
+    repeatFrames_.clear();
+    lastFrameSize_ = 0;
     readyTimer_.stop();
+    expectedCheck_ = -1;
     pointQueue_.clear();
+    sources_.clear();
+    remainingPoints_ = 0;
+    needsPlaceholder_ = false;
+    hasPlaceholder_ = false;
+    isFinishedArmed_ = false;
+    finishedTimer_.stop();
     easyLase_.idle();
+    deviceClock_.reset();
+    wasFull_ = false;
+    cues_.clear();
+    contentEnd_ = 0;
+    submittedPos_ = 0;
+    scheduledCues_.clear();
+    cueTimer_.stop();
     if (doCallActiveCallback) activeCallback_(false);
+    scheduleTimed();
 }
 
-void Laser::show(const Points & points, bool repeat, quint16 pps)
+void Laser::resetStream()
 {
-    if (!verifyThreadCall(&Laser::show, points, repeat, pps)) return;
-    logFunctionTrace
-
-    // empty input
-    if (points.isEmpty() || pps == 0) {
-        idle();
-        return;
-    }
+    isStreaming_      = false;
+    isStreamRecorded_ = false;
+    streamRecord_.clear();
+    pendingRepeat_.clear();
+}
 
-    int replication = qMax(1, qRound((double)MaxSpeed / (double)pps));
-    logDebug("showing %1 points %2 repeat and %3 pps (replication: %4)",
-        points.size(), repeat ? "with" : "without", pps, replication);
+bool Laser::isStreamFull(qsizetype count) const
+{
+    // backpressure: one chunk is always accepted, so that huge chunks cannot stall the stream
+    if (remainingPoints_ == 0 || remainingPoints_ + count <= StreamBudget) return false;
+    logTrace("rejecting %1 device points, %2 points buffered", count, remainingPoints_);
+    return true;
+}
 
+void Laser::beginContent(bool repeat)
+{
     if (activeCallback_ && !isActive_) activeCallback_(true);
-
-    EasyLase::Points pointBlock;
+    ring_.reset();
+    playingContent_ = 0;
 
     // manage smooth continuation
-    if (isActive_) {
-        if (isRepeating_ || repeat) {
-            pointQueue_.clear();
-            easyLase_.idle();
-        } else if (!pointQueue_.isEmpty()) {
-            pointQueue_.removeLast();   // Placeholder
-            if (!pointQueue_.isEmpty() && pointQueue_.last().size() < EasyLase::MaxPoints) {
-                pointBlock = pointQueue_.takeLast();
-            }
-        }
+    const bool isReplacing = isActive_ && (isRepeating_ || repeat || isTimedSwitch_);
+    if (!isActive_ || isReplacing) {
+        cues_.clear();
+        contentEnd_ = 0;
+        submittedPos_ = 0;
     }
-
-    pointBlock.reserve(EasyLase::MaxPoints);
-    for (const Point & p : points) {
-        EasyLase::Point ep = convertPoint(p);
-        for (int i = 0 ; i < replication ; ++i) {
-            pointBlock << ep;
-            if (pointBlock.size() == EasyLase::MaxPoints) {
-                pointQueue_ << pointBlock;
-                pointBlock.resize(0);
-            }
+    if (isReplacing) {
+        pointQueue_.clear();
+        sources_.clear();
+        remainingPoints_ = 0;
+        needsPlaceholder_ = false;
+        hasPlaceholder_ = false;
+        if (isSeamless_ || isTimedSwitch_) {
+            // new content follows the frames already in the device
+            isSwitching_ = true;
+            switchTimer_.start();
+        } else {
+            easyLase_.idle();
+            deviceClock_.reset();
+            scheduledCues_.clear();
+            cueTimer_.stop();
         }
     }
-    if (!pointBlock.isEmpty()) pointQueue_ << pointBlock;
 
     isActive_ = true;
     readyTimer_.stop();
+    expectedCheck_ = -1;
+    repeatJob_ = 0;
+    repeatFrames_.clear();
     isRepeating_ = repeat;
     repeatPos_ = 0;
-    finishedCallQueueSize_ = -1;
+    isFinishedArmed_ = false;
+}
 
-    if (repeat) {
-        if (pointQueue_.size() == 1) {
-            // EasyLase does the repetition.
-            easyLase_.show(EasyLase::MaxSpeed, pointQueue_.takeFirst());
-            return;
-        }
+void Laser::enqueueRepeat(const EasyLase::Points & points, const Cues & cues)
+{
+    beginContent(true);
+    cues_       = cues;
+    contentEnd_ = points.size();
+
+    for (qsizetype pos = 0 ; pos < points.size() ; pos += EasyLase::MaxPoints) {
+        pointQueue_ << points.mid(pos, EasyLase::MaxPoints);
+    }
+
+    if (pointQueue_.size() == 1 && !isSwitching_) {
+        // EasyLase does the repetition.
+        submit(pointQueue_.first());
     } else {
+        checkEasyLaseReady();
+    }
+    scheduleTimed();
+}
+
+void Laser::enqueueOnce(const Source & source)
+{
+    beginContent(false);
+
+    // continue last block of previous content
+    if (hasPlaceholder_) {
+        pointQueue_.removeLast();
+        hasPlaceholder_ = false;
+        --contentEnd_;
+    }
+
+    const qsizetype count = source.devicePoints.isEmpty() ?
+        source.points.size() * replication(source.pps) : source.devicePoints.size();
+    for (Cue cue : source.cues) {
+        cue.point += contentEnd_;
+        cues_ << cue;
+    }
+    contentEnd_ += count;
+    remainingPoints_ += count;
+    if (finishedCallback_) isFinishedArmed_ = true;
+
+    sources_ << source;
+    if (source.devicePoints.isEmpty() && count > ParallelSize) sources_.last().job = ++lastJob_;
+    needsPlaceholder_ = true;
+    fillQueue();
+    checkEasyLaseReady();
+    scheduleTimed();
+    scheduleFinished();
+}
+
+void Laser::fillQueue()
+{
+    while (!sources_.isEmpty()) {
+        Source & source = sources_.first();
+
+        if (source.job) {
+            dispatchConversion(source);
+            const qsizetype absPos = source.base + source.pos;
+            if (!source.frames.contains(absPos) || pointQueue_.size() >= LookAheadFrames) return;
+
+            const EasyLase::Points frame = source.frames.take(absPos);
+            source.pos += qMin<qsizetype>(EasyLase::MaxPoints / replication(source.pps), source.points.size() - source.pos);
+            for (qsizetype pos = 0 ; pos < frame.size() ; ) {
+                if (pointQueue_.isEmpty() || pointQueue_.last().size() == EasyLase::MaxPoints) {
+                    pointQueue_ << EasyLase::Points();
+                    pointQueue_.last().reserve(EasyLase::MaxPoints);
+                }
+                EasyLase::Points & block = pointQueue_.last();
+                const qsizetype count = qMin<qsizetype>(EasyLase::MaxPoints - block.size(), frame.size() - pos);
+                block.append(frame.mid(pos, count));
+                pos += count;
+            }
+
+            if (source.pos == source.points.size()) {
+                sources_.removeFirst();
+            } else if (source.pos >= CompactSize && source.pos * 2 >= source.points.size()) {
+                // running conversions keep their own copy
+                source.points = source.points.mid(source.pos);
+                source.base += source.pos;
+                source.pos = 0;
+            }
+            continue;
+        }
+
+        const bool      isConverted = !source.devicePoints.isEmpty();
+        const int       rep         = isConverted ? 1 : replication(source.pps);
+        const qsizetype size        = isConverted ? source.devicePoints.size() : source.points.size();
+
+        if (pointQueue_.isEmpty() || EasyLase::MaxPoints - pointQueue_.last().size() < rep) {
+            if (pointQueue_.size() >= LookAheadFrames) return;
+            pointQueue_ << EasyLase::Points();
+            pointQueue_.last().reserve(EasyLase::MaxPoints);
+        }
+
+        EasyLase::Points & block = pointQueue_.last();
+        const qsizetype count = qMin<qsizetype>((EasyLase::MaxPoints - block.size()) / rep, size - source.pos);
+        if (isConverted) block.append(source.devicePoints.mid(source.pos, count));
+        else             outputCorrection_.convert(source.points, source.pos, count, source.pps, block);
+        source.pos += count;
+
+        // clipping may have added some points
+        if (block.size() > EasyLase::MaxPoints) {
+            EasyLase::Points overflow = block.mid(EasyLase::MaxPoints);
+            block.resize(EasyLase::MaxPoints);
+            pointQueue_ << overflow;
+        }
+
+        // release consumed source points
+        if (source.pos == size) {
+            sources_.removeFirst();
+        } else if (source.pos >= CompactSize && source.pos * 2 >= size) {
+            if (isConverted) source.devicePoints = source.devicePoints.mid(source.pos);
+            else             source.points       = source.points.mid(source.pos);
+            source.pos = 0;
+        }
+    }
+
+    if (needsPlaceholder_) {
         // Placeholder to finish last block before going idle.
         pointQueue_ << EasyLase::Points(1, {});
-        if (finishedCallback_) finishedCallQueueSize_ = points.size() / EasyLase::MaxPoints / 2 + 1;
+        needsPlaceholder_ = false;
+        hasPlaceholder_ = true;
+        ++contentEnd_;
     }
-    checkEasyLaseReady();
+}
+
+void Laser::convertRepeat(const Points & points, quint16 pps, const Cues & cues)
+{
+    const qsizetype chunk = EasyLase::MaxPoints / replication(pps);
+    repeatJob_ = ++lastJob_;
+    repeatFrames_.clear();
+    repeatCues_ = cues;
+    repeatChunksLeft_ = 0;
+    for (qsizetype pos = 0 ; pos < points.size() ; pos += chunk) {
+        convertOnPool(repeatJob_, points, pos, pos, qMin(chunk, points.size() - pos), pps);
+        ++repeatChunksLeft_;
+    }
+    logDebug("converting %1 points in %2 chunks on %3 threads", points.size(), repeatChunksLeft_, pool_.maxThreadCount());
+}
+
+void Laser::dispatchConversion(Source & source)
+{
+    const qsizetype chunk = EasyLase::MaxPoints / replication(source.pps);
+    const qsizetype end   = source.base + source.points.size();
+    while (source.dispatchPos < end && source.dispatchPos - source.base - source.pos < ChunksAhead * chunk) {
+        const qsizetype count = qMin(chunk, end - source.dispatchPos);
+        convertOnPool(source.job, source.points, source.dispatchPos - source.base, source.dispatchPos, count, source.pps);
+        source.dispatchPos += count;
+    }
+}
+
+void Laser::convertOnPool(quint64 job, const Points & points, qsizetype begin, qsizetype absPos, qsizetype count,
+    quint16 pps)
+{
+    pool_.start([this, job, points, begin, absPos, count, pps, correction = outputCorrection_]() {
+        EasyLase::Points frame;
+        correction.convert(points, begin, count, pps, frame);
+        frameConverted(job, absPos, frame);
+    });
+}
+
+void Laser::frameConverted(quint64 job, qsizetype absPos, const EasyLase::Points & points)
+{
+    if (!verifyThreadCall(&Laser::frameConverted, job, absPos, points)) return;
+
+    if (job == repeatJob_) {
+        repeatFrames_[absPos] = points;
+        if (--repeatChunksLeft_ > 0) return;
+        EasyLase::Points all;
+        for (const EasyLase::Points & frame : std::as_const(repeatFrames_)) all << frame;
+        quint64 id = 0;
+        if (!repeatContent_.input.isEmpty()) {
+            repeatContent_.devicePoints = all;
+            id = cacheContent(repeatContent_);
+            repeatContent_ = CachedContent();
+        }
+        enqueueRepeat(all, repeatCues_);
+        playingContent_ = id;
+        return;
+    }
+
+    for (Source & source : sources_) {
+        if (source.job != job) continue;
+        source.frames[absPos] = points;
+        fillQueue();
+        return;
+    }
+    // results of replaced content are dropped
 }
 
 void Laser::easyLaseError()
 {
-    readyTimer_.stop();
-    pointQueue_.clear();
-    hasError_ = true;
     error_ = easyLase_.errorString();
+    // failed reconnects are no news
+    if (isRecovering_) return;
+    hasError_ = true;
     if (errorCallback_) errorCallback_(error_);
+    beginRecovery();
+}
+
+void Laser::beginRecovery()
+{
+    // content stays, the device lost its buffers
+    logInfo("device lost, recovering");
+    isRecovering_ = true;
+    recoveryTimer_.start();
+    ++recoveryStats_.errors;
+    readyTimer_.stop();
+    expectedCheck_ = -1;
+    isFinishedArmed_ = false;
+    finishedTimer_.stop();
+    scheduledCues_.clear();
+    cueTimer_.stop();
+    deviceClock_.reset();
+    wasFull_ = false;
+    lastFrameSize_ = 0;
+
+    // a glitch may be over already, otherwise hot-plug events shortcut the backoff
+    deviceWatcher_.start();
+    reconnectDelay_ = 0;
+    reconnectTimer_.singleShot(0);
+}
+
+bool Laser::endRecovery()
+{
+    if (easyLase_.hasError()) return false;
+    isRecovering_ = false;
+    hasError_ = false;
+    error_ = QString();
+    reconnectTimer_.stop();
+    deviceWatcher_.stop();
+
+    const double time = recoveryTimer_.nsecsElapsed() / 1e6;
+    dao::RecoveryStats & rs = recoveryStats_;
+    ++rs.reconnects;
+    rs.lastRecovery = time;
+    rs.maxRecovery  = qMax(rs.maxRecovery, time);
+    logInfo("device recovered after %1ms", qRound(time));
+    return true;
+}
+
+void Laser::reconnect()
+{
+    if (!isRecovering_) return;
+    easyLase_.connect();
+    if (!endRecovery()) {
+        ++recoveryStats_.failedAttempts;
+        reconnectDelay_ = qBound(MinReconnect, reconnectDelay_ * 2, MaxReconnect);
+        logTrace("reconnect failed, retrying in %1ms", reconnectDelay_);
+        reconnectTimer_.singleShot(reconnectDelay_ / 1000.0);
+        return;
+    }
+    if (!isActive_) return;
+
+    // continue with the next frame
+    if (repeatPos_ >= pointQueue_.size()) repeatPos_ = 0;
+    checkEasyLaseReady();
+    scheduleTimed();
+    scheduleFinished();
+}
+
+void Laser::deviceAdded()
+{
+    if (!verifyThreadCall(&Laser::deviceAdded)) return;
+    if (!isRecovering_) return;
+    logFunctionTrace
+    reconnectDelay_ = 0;
+    reconnectTimer_.stop();
+    reconnect();
+}
+
+void Laser::scheduleCheck()
+{
+    readyTimer_.singleShot(PollInterval);
+    expectedCheck_ = now() + qint64(PollInterval * 1e6);
 }
 
 void Laser::checkEasyLaseReady()
 {
-    if (!easyLase_.isReady()) {
-        readyTimer_.singleShot(0.002);
+    if (expectedCheck_ >= 0) {
+        const double latency = qMax<qint64>(0, now() - expectedCheck_);
+        expectedCheck_ = -1;
+        dao::TimerStats & ts = timerStats_;
+        ++ts.count;
+        ts.meanLatency += (latency - ts.meanLatency) / ts.count;
+        ts.maxLatency   = qMax(ts.maxLatency, latency);
+        if (latency > PollInterval * 1e6) ++ts.lateCount;
+    }
+
+    if (isRecovering_) return;
+
+    // frame boundaries calibrate the clock
+    const bool   isReady = easyLase_.isReady();
+    const qint64 time    = now();
+    if (isReady && wasFull_) deviceClock_.frameFinished(lastPoll_, time);
+    wasFull_  = !isReady;
+    lastPoll_ = time;
+
+    if (!isReady) {
+        scheduleCheck();
+        return;
+    }
+    if (isTimedDue_) {
+        activateTimed();
+        return;
+    }
+    if (ring_) {
+        consumeRing();
         return;
     }
     if (isRepeating_) {
-        easyLase_.show(EasyLase::MaxSpeed, pointQueue_[repeatPos_++]);
+        if (handleTimed(pointQueue_[repeatPos_])) return;
+        const bool wasSwitching = isSwitching_;
+        if (!submit(pointQueue_[repeatPos_])) return;
+        ++repeatPos_;
         if (repeatPos_ == pointQueue_.size()) repeatPos_ = 0;
-        readyTimer_.singleShot(0.002);
+        if (pointQueue_.size() == 1) {
+            // EasyLase does the repetition, a switched frame with a jump is followed by the clean one
+            if (wasSwitching) scheduleCheck();
+            return;
+        }
+        scheduleCheck();
 
         // check that next show has enough points
         EasyLase::Points & current = pointQueue_[repeatPos_];
@@ -216,13 +1110,271 @@ void Laser::checkEasyLaseReady()
             next.remove(0, missing);
         }
     } else {
-        if (pointQueue_.isEmpty()) {
-            logDebug("out of points");
-            idle();
+        if (pointQueue_.isEmpty() && !pendingRepeat_.isEmpty()) {
+            // streamed content continues as loop
+            logDebug("repeating stream of %1 points", pendingRepeat_.size());
+            const EasyLase::Points points = pendingRepeat_;
+            pendingRepeat_.clear();
+            isRepeating_ = true;
+            repeatPos_ = 0;
+            cues_.clear();
+            contentEnd_ = points.size();
+            submittedPos_ = 0;
+            for (qsizetype pos = 0 ; pos < points.size() ; pos += EasyLase::MaxPoints) {
+                pointQueue_ << points.mid(pos, EasyLase::MaxPoints);
+            }
+            checkEasyLaseReady();
+            scheduleTimed();
+        } else if (pointQueue_.isEmpty() && !sources_.isEmpty()) {
+            logTrace("waiting for conversion");
+            scheduleCheck();
+        } else if (pointQueue_.isEmpty()) {
+            if (isStreaming_) logWarn("stream ran out of points");
+            else              logDebug("out of points");
+            stop();
+        } else {
+            if (handleTimed(pointQueue_.first())) return;
+            // kept until written, so that it is sent again after a recovery
+            if (!submit(pointQueue_.first())) return;
+            const EasyLase::Points block = pointQueue_.takeFirst();
+            if (pointQueue_.isEmpty()) hasPlaceholder_ = false;
+            fillQueue();
+            scheduleCheck();
+
+            remainingPoints_ = qMax<qsizetype>(0, remainingPoints_ - block.size());
+            scheduleFinished();
+        }
+    }
+}
+
+bool Laser::handleTimed(const EasyLase::Points & block)
+{
+    if (timed_.isEmpty()) return false;
+    const qint64 start  = deviceClock_.nextStart(now());
+    const qint64 target = timed_.first().time;
+    if (target >= start + deviceClock_.duration(block.size())) return false;
+
+    // cut this frame to end right at target
+    const qsizetype count = qRound64((target - start) * deviceClock_.pps() / 1e6);
+    if (count > 0 && count < block.size()) {
+        if (!submit(block.mid(0, count))) return true;
+        isTimedDue_ = true;
+        scheduleCheck();
+    } else {
+        activateTimed();
+    }
+    return true;
+}
+
+void Laser::activateTimed()
+{
+    isTimedDue_ = false;
+    if (timed_.isEmpty()) return;
+
+    const Timed timed = timed_.takeFirst();
+    timedTarget_   = timed.time;
+    isTimedSwitch_ = true;
+    if (timed.repeat) enqueueRepeat(timed.points, timed.cues);
+    else              enqueueOnce(Source{ .devicePoints = timed.points, .cues = timed.cues });
+    isTimedSwitch_ = false;
+}
+
+void Laser::scheduleTimed()
+{
+    timedTimer_.stop();
+    if (timed_.isEmpty() || isTimedDue_) return;
+
+    // checked with every submitted frame while polling
+    if (isActive_ && !(isRepeating_ && pointQueue_.size() == 1)) return;
+
+    // device is idle or repeats a single frame
+    const qint64 target = timed_.first().time;
+    const qint64 wakeup = isActive_ ? deviceClock_.submitTime(target) : target;
+    timedTimer_.singleShot(qMax<qint64>(0, wakeup - now()) / 1e6);
+}
+
+void Laser::scheduleCues(qint64 start, qsizetype count, qint64 period)
+{
+    const qsizetype begin = submittedPos_;
+    submittedPos_ += count;
+    if (cues_.isEmpty()) return;
+
+    const qsizetype cycle = isRepeating_ ? contentEnd_ : 0;
+    for (const Cue & cue : std::as_const(cues_)) {
+        qsizetype offset = cue.point - begin;
+        if (cycle > 0) offset = (offset % cycle + cycle) % cycle;
+        if (offset < 0 || offset >= count) continue;
+        scheduledCues_ << ScheduledCue{
+            .time   = start + deviceClock_.duration(offset),
+            .ttl    = cue.ttl,
+            .period = period
+        };
+    }
+    std::sort(scheduledCues_.begin(), scheduledCues_.end(),
+        [](const ScheduledCue & a, const ScheduledCue & b) { return a.time < b.time; });
+    scheduleCueTimer();
+}
+
+void Laser::scheduleCueTimer()
+{
+    cueTimer_.stop();
+    if (scheduledCues_.isEmpty()) return;
+    cueTimer_.singleShot(qMax<qint64>(0, scheduledCues_.first().time - CueSpin - now()) / 1e6);
+}
+
+void Laser::fireCues()
+{
+    while (!scheduledCues_.isEmpty()) {
+        const ScheduledCue cue = scheduledCues_.first();
+        qint64 time = now();
+        if (cue.time - time > CueSpin) break;
+        while (time < cue.time) time = now();
+
+        scheduledCues_.removeFirst();
+        easyLase_.setTTL(cue.ttl);
+        const qint64 actual = now();
+        logTrace("cue %1 issued %2us after target", cue.ttl, actual - cue.time);
+        if (cueCallback_) cueCallback_(cue.ttl, cue.time, actual);
+
+        if (cue.period > 0) {
+            ScheduledCue next = cue;
+            next.time += cue.period;
+            auto it = scheduledCues_.begin();
+            while (it != scheduledCues_.end() && it->time <= next.time) ++it;
+            scheduledCues_.insert(it, next);
+        }
+    }
+    scheduleCueTimer();
+}
+
+qint64 Laser::bufferedDuration(qint64 time) const
+{
+    return deviceClock_.nextStart(time) - time + deviceClock_.duration(remainingPoints_);
+}
+
+void Laser::scheduleFinished()
+{
+    finishedTimer_.stop();
+    if (!isFinishedArmed_) return;
+    const qint64 wait = bufferedDuration(now()) - finishedLead_ * 1000;
+    finishedTimer_.singleShot(qMax<qint64>(0, wait) / 1e6);
+}
+
+void Laser::callFinished()
+{
+    if (!isFinishedArmed_) return;
+
+    // timer may be early and content may have grown
+    const qint64 remaining = bufferedDuration(now());
+    if (remaining > finishedLead_ * 1000 + FinishedSlack) {
+        scheduleFinished();
+        return;
+    }
+    isFinishedArmed_ = false;
+    logTrace("finished callback with %1us buffered", remaining);
+    finishedCallback_(remaining / 1000);
+}
+
+void Laser::consumeRing()
+{
+    int count = 0;
+    const EasyLase::Point * points = ring_->peek(count);
+    if (!points) {
+        if (ring_->isClosed()) {
+            logDebug("shared memory ring was closed");
+            stop();
+        } else if (!timed_.isEmpty() && timed_.first().time <= deviceClock_.nextStart(now())) {
+            activateTimed();
+        } else {
+            // the device repeats the last frame
+            scheduleCheck();
+        }
+        return;
+    }
+    if (!timed_.isEmpty() && handleTimed(EasyLase::Points(points, points + count))) return;
+
+    // straight from shared memory without correction
+    // the slot stays, if the frame was not shown
+    if (count > 0 && outputCorrection_.isIdentity()) {
+        if (!submit(points, count)) return;
+    } else if (count > 0) {
+        EasyLase::Points corrected = outputCorrection_.correct(points, count);
+        // clipping may add a few points
+        if (corrected.size() > EasyLase::MaxPoints) corrected.resize(EasyLase::MaxPoints);
+        if (!submit(corrected)) return;
+    }
+    ring_->release();
+    scheduleCheck();
+}
+
+bool Laser::submit(const EasyLase::Point * points, qsizetype count, const EasyLase::Points * shared)
+{
+    // resumed after recovery
+    if (isRecovering_) return false;
+
+    qsizetype frameSize = count;
+    qsizetype prefix    = 0;
+    qsizetype rest      = count;
+    EasyLase::Points block;
+    if (!isSwitching_) {
+        easyLase_.show(EasyLase::MaxSpeed, points, count);
+    } else {
+        isSwitching_ = false;
+        if (isBlankedSwitch_ && lastFrameSize_ > 0) appendBlankJump(block, lastPoint_, points[0]);
+        prefix = block.size();
+        // this frame loses some points, if the jump does not fit
+        rest = qMin(count, EasyLase::MaxPoints - prefix);
+        block.resize(prefix + rest);
+        std::copy(points, points + rest, block.begin() + prefix);
+        easyLase_.show(EasyLase::MaxSpeed, block);
+        frameSize = block.size();
+    }
+    // the frame was not shown, the caller keeps it for after the recovery
+    if (isRecovering_) return false;
+
+    if (!block.isEmpty()) {
+        // new frame becomes visible after the one currently played
+        switchLatency_ = switchTimer_.nsecsElapsed() / 1e9 + (double)lastFrameSize_ / MaxSpeed;
+        logDebug("switched content seamlessly, latency: %1ms", qRound(switchLatency_ * 1000));
+    }
+    lastPoint_     = points[count - 1];
+    lastFrameSize_ = frameSize;
+
+    const qint64 start = deviceClock_.submit(now(), frameSize);
+    if (!fanout_.isEmpty()) {
+        // vectors are implicitly shared, only frames from raw memory get copied
+        if      (!block.isEmpty()) deliverFrame(start, block);
+        else if (shared)           deliverFrame(start, *shared);
+        else                       deliverFrame(start, EasyLase::Points(points, points + count));
+    }
+
+    // repetitions of the previous frame end here
+    for (auto it = scheduledCues_.begin() ; it != scheduledCues_.end() ; ) {
+        if (it->period > 0 && it->time >= start) {
+            it = scheduledCues_.erase(it);
         } else {
-            easyLase_.show(EasyLase::MaxSpeed, pointQueue_.takeFirst());
-            readyTimer_.singleShot(0.002);
-            if (pointQueue_.size() == finishedCallQueueSize_) finishedCallback_();
+            it->period = 0;
+            ++it;
         }
     }
+    // a single repeated frame is not submitted again, unless it has a jump
+    const bool   isRepeated = isRepeating_ && pointQueue_.size() == 1 && block.isEmpty();
+    const qint64 period     = isRepeated ? deviceClock_.duration(frameSize) : 0;
+    scheduleCues(start + deviceClock_.duration(prefix), rest, period);
+    submittedPos_ += count - rest;
+    if (timedTarget_ >= 0) {
+        logDebug("timed content started %1us after target", start - timedTarget_);
+        if (presentedCallback_) presentedCallback_(timedTarget_, start);
+        timedTarget_ = -1;
+    }
+    return true;
+}
+
+void Laser::deliverFrame(qint64 start, const EasyLase::Points & points)
+{
+    fanout_.deliver(std::make_shared<const FrameSink::Frame>(FrameSink::Frame{
+        .seq    = frameSeq_++,
+        .start  = start,
+        .points = points
+    }));
 }
@@ -1,7 +1,22 @@
 #pragma once
 
+#include <dao/contentcachestats.h>
+#include <dao/lasercue.h>
+#include <dao/levelofdetailstats.h>
 #include <dao/laserpoint.h>
+#include <dao/recoverystats.h>
+#include <dao/timerstats.h>
+#include <laser/deviceclock.h>
+#include <laser/devicewatcher.h>
 #include <laser/easylase.h>
+#include <laser/framefanout.h>
+#include <laser/levelofdetail.h>
+#include <laser/outputcorrection.h>
+#include <laser/pathoptimizer.h>
+#include <laser/pointbuffer.h>
+#include <laser/realtime.h>
+#include <laser/resampler.h>
+#include <laser/shmring.h>
 
 #include <cflib/util/evtimer.h>
 #include <cflib/util/threadverify.h>
@@ -11,12 +26,22 @@ class Laser : private cflib::util::ThreadVerify
 public:
     static constexpr quint16 MaxSpeed           = 59899;
     static constexpr quint16 OptimalPointCount  = EasyLase::MaxPoints;
+    static constexpr int     StreamBudget       = 16 * EasyLase::MaxPoints;  // buffered device points
+    static constexpr int     StreamRepeatLimit  = 64 * EasyLase::MaxPoints;  // recorded device points
+    static constexpr int     DefaultFinishedLead = 200;                       // ms
+    static constexpr int     ContentCacheSize   = 8;                         // converted shows
+    static constexpr int     ContentCacheLimit  = StreamBudget;              // device points per cached show
 
     using Point      = dao::LaserPoint;
-    using Points     = dao::LaserPoints;
+    using Points     = PointBuffer;
+    using Cue        = dao::LaserCue;
+    using Cues       = dao::LaserCues;
     using VoidFunc   = std::function<void ()>;
     using BoolFunc   = std::function<void (bool)>;
     using StringFunc = std::function<void (const QString &)>;
+    using TimeFunc   = std::function<void (qint64 target, qint64 start)>;
+    using CueFunc    = std::function<void (quint8 ttl, qint64 target, qint64 actual)>;
+    using FinishFunc = std::function<void (int remaining)>;
 
 public:
     Laser();
@@ -24,48 +49,299 @@ public:
 
     void reset();
 
+    // state after the queued commands
     bool hasError() const;
+    // does not wait for queued commands, so it is the state before them
+    bool hasErrorNow() const { return hasError_; }
     QString errorString() const;
 
+    // Device errors start an automatic recovery: hot-plug events and retries with backoff reconnect,
+    // then the current content continues with its next frame. hasError() is true until then.
     // attention: this callback is called from an internal thread
     void setErrorCallback(StringFunc callback);
 
     // called when Laser changes on/off state
     void setActiveCallback(BoolFunc callback);
 
-    // this is called between 137ms and 274ms before last no-repeat show ends.
-    void setFinishedCallback(VoidFunc callback);
+    // Called leadTime ms before the predicted end of the last no-repeat show.
+    // remaining is the duration in ms still buffered at that time.
+    void setFinishedCallback(FinishFunc callback, int leadTime = DefaultFinishedLead);
+
+    // called when timed content started (see showAt(...))
+    void setPresentedCallback(TimeFunc callback);
+
+    // called after a cue was issued, target is the predicted play time of its point
+    void setCueCallback(CueFunc callback);
 
     // All commands are executed asynchronously.
     // This call blocks until queue is empty.
     void waitForFinish();
 
-    void on();
-    void off();
+    // done is called from the internal thread after the command was executed,
+    // with false if the device has an error
+    void on(BoolFunc done = BoolFunc());
+    void off(BoolFunc done = BoolFunc());
+
+    // Applies scheduling, cpu pinning and stack prefaulting to the internal thread.
+    // Returns false, if it fell back to something less.
+    bool setRealtime(const realtime::Config & config);
+
+    // latency of the internal device polling
+    dao::TimerStats timerStats() const;
+    void resetTimerStats();
+
+    dao::RecoveryStats recoveryStats() const;
+    dao::ContentCacheStats contentCacheStats() const;
+    dao::LevelOfDetailStats levelOfDetailStats() const;
+
+    // Reorders lit segments of following repeated shows and inserts blank jumps / dwell points.
+    void setPathOptimizer(const PathOptimizer::Config & config);
+
+    // Resamples following repeated shows to a fixed point budget (before path optimization).
+    void setResampler(const Resampler::Config & config);
+
+    // Simplification of following shows with a target refresh rate (before resampling and path optimization).
+    void setLevelOfDetail(const LevelOfDetail::Config & config);
+
+    // Applied to all following shows while converting to device format.
+    // attention: points are stored in the range -2.0 ... 2.0 before correction (see PointBuffer),
+    // content further out is clamped, even if the transform would scale it into view.
+    void setOutputCorrection(const OutputCorrection & correction);
+
+    // Without seamless switching, replacing content clears the device buffers (visible gap).
+    // With it, new content starts right after the frame currently played,
+    // optionally with a blanked jump from the old end point to the new start point.
+    void setSeamlessSwitching(bool seamless, bool blankedTransition);
+
+    // estimated seconds from last seamless switch request until new content was visible
+    double switchLatency() const;
 
     // If there was something active with repeat, it is replaced by new points,
     // otherwise new points will be appended.
-    void idle();
-    void show(const Points & points, bool repeat = false, quint16 pps = MaxSpeed);
+    void idle(BoolFunc done = BoolFunc());
+    // Cues are issued when their point is played (with every repetition).
+    // attention: cues of repeated content are exact only without resampler, path optimizer and targetRate,
+    // otherwise their position is scaled with the point count.
+    // Converted content is cached by its points, pps, repeat and targetRate. Showing the repeated content,
+    // which is playing already, does nothing.
+    // With targetRate (Hz), repeated frames are simplified until they refresh that often (see LevelOfDetail).
+    void show(const Points & points, bool repeat = false, quint16 pps = MaxSpeed, const Cues & cues = Cues(),
+        double targetRate = 0.0);
     void show(const Point & point) { return show(Points(1, point), true); }
 
+    // Same as show(...) but with points already in device format at EasyLase::MaxSpeed.
+    void showConverted(const EasyLase::Points & points, bool repeat);
+
+    // Replaces the active content at the given time (us, see now()) within one frame period.
+    // The actual start is reported with the presented callback. idle() drops pending timed content.
+    void showAt(qint64 time, const Points & points, bool repeat, quint16 pps = MaxSpeed, const Cues & cues = Cues());
+
+    // monotonic time in us used for timed content
+    static qint64 now();
+
+    // point rate of the device, calibrated while playing
+    double devicePps() const;
+
+    // Streaming session for content of arbitrary length, appended chunk by chunk.
+    // Playback starts with the first chunk, following shows end the session.
+    // appendStream returns false, if the chunk was rejected, because too many points are buffered.
+    // With endStream(true) the whole stream repeats, if it was not longer than StreamRepeatLimit.
+    void beginStream(quint16 pps = MaxSpeed);
+    bool appendStream(const Points & points);
+    // Same as appendStream(...) but with points already in device format at EasyLase::MaxSpeed.
+    // Such streams cannot be repeated.
+    bool appendConvertedStream(const EasyLase::Points & points);
+    void endStream(bool repeat);
+    // Ends the stream, the points in device format repeat after the streamed content.
+    void endConvertedStream(const EasyLase::Points & points);
+
+    // Shows the frames of a shared memory ring as they are written (see ShmServer).
+    // The last frame repeats until the next one is there, other shows end it.
+    // Calling it again with the active ring wakes up consumption after new frames.
+    // A closed ring ends, when all of its frames were shown.
+    void showRing(std::shared_ptr<ShmRing> ring);
+
+    // Frames sent to the device are delivered to the sink as well, without copying their points.
+    // Each sink has its own queue and thread, a full queue drops frames according to the policy.
+    // Returns an id for removeFrameSink(...) and frameSinkStats(...).
+    int addFrameSink(std::shared_ptr<FrameSink> sink, const FrameFanout::Config & config = FrameFanout::Config());
+    void removeFrameSink(int id);
+    FrameFanout::Stats frameSinkStats(int id) const;
+
+    // Converts to device format (without output correction), replicating points to match pps.
+    static EasyLase::Points convert(const dao::LaserPoints & points, quint16 pps);
+    static EasyLase::Point  convert(const Point & point);
+    static int replication(quint16 pps);
+
 private:
+    struct Timed
+    {
+        qint64           time;
+        EasyLase::Points points;
+        bool             repeat;
+        Cues             cues;    // device points
+    };
+
+    struct ScheduledCue
+    {
+        qint64 time;
+        quint8 ttl;
+        qint64 period;  // > 0 while a single frame repeats
+    };
+
+    // one-shot content, either points or device points
+    struct Source
+    {
+        Points           points;
+        EasyLase::Points devicePoints;
+        quint16          pps = MaxSpeed;
+        qsizetype        pos = 0;
+        Cues             cues;    // device points
+
+        // large sources are converted on the pool, chunks are keyed by absolute position
+        quint64                           job = 0;
+        qsizetype                         base = 0;         // points released by compaction
+        qsizetype                         dispatchPos = 0;  // absolute
+        QMap<qsizetype, EasyLase::Points> frames;
+    };
+
+    // converted show, most recently used first
+    struct CachedContent
+    {
+        size_t                  hash;
+        Points                  input;
+        quint16                 pps;
+        bool                    repeat;
+        double                  targetRate;
+        qsizetype               shownSize;     // points after prepare(...)
+        EasyLase::Points        devicePoints;  // with output correction
+        dao::LevelOfDetailStats lod;
+        quint64                 id;
+    };
+
+    Points prepare(const Points & input, bool repeat, quint16 pps, double targetRate = 0.0,
+        dao::LevelOfDetailStats * lod = nullptr) const;
+    const CachedContent * findContent(size_t hash, const Points & input, quint16 pps, bool repeat, double targetRate);
+    quint64 cacheContent(CachedContent content);
+    void clearContentCache();
+    void stop();
+    void resetStream();
+    void repeatAfterStream(const EasyLase::Points & points);
+    bool isStreamFull(qsizetype count) const;
+    void beginContent(bool repeat);
+    void enqueueRepeat(const EasyLase::Points & points, const Cues & cues = Cues());
+    void enqueueOnce(const Source & source);
+    void fillQueue();
+    void convertRepeat(const Points & points, quint16 pps, const Cues & cues);
+    void dispatchConversion(Source & source);
+    void convertOnPool(quint64 job, const Points & points, qsizetype begin, qsizetype absPos, qsizetype count,
+        quint16 pps);
+    void frameConverted(quint64 job, qsizetype absPos, const EasyLase::Points & points);
+    // false, if the device failed, then the frame has to be submitted again after the recovery
+    bool submit(const EasyLase::Points & points) { return submit(points.constData(), points.size(), &points); }
+    bool submit(const EasyLase::Point * points, qsizetype count, const EasyLase::Points * shared = nullptr);
+    void deliverFrame(qint64 start, const EasyLase::Points & points);
+    void consumeRing();
     void easyLaseError();
+    void beginRecovery();
+    bool endRecovery();
+    void reconnect();
+    void deviceAdded();
+    void scheduleCheck();
     void checkEasyLaseReady();
+    bool handleTimed(const EasyLase::Points & block);
+    void activateTimed();
+    void scheduleTimed();
+    void scheduleCues(qint64 start, qsizetype count, qint64 period);
+    void scheduleCueTimer();
+    void fireCues();
+    void scheduleFinished();
+    void callFinished();
+    qint64 bufferedDuration(qint64 time) const;
 
 private:
     EasyLase                easyLase_;
 
-    bool                    hasError_ = false;
+    std::atomic<bool>       hasError_ = false;
     QString                 error_;
     StringFunc              errorCallback_;
     BoolFunc                activeCallback_;
 
+    PathOptimizer           pathOptimizer_;
+    Resampler               resampler_;
+    LevelOfDetail           levelOfDetail_;
+    OutputCorrection        outputCorrection_;
+
+    QThreadPool             pool_;
+    quint64                 lastJob_ = 0;
+    quint64                 repeatJob_ = 0;
+    int                     repeatChunksLeft_ = 0;
+    QMap<qsizetype, EasyLase::Points> repeatFrames_;
+    Cues                    repeatCues_;
+    CachedContent           repeatContent_;         // uncached content converted on the pool
+
+    QList<CachedContent>    contentCache_;
+    quint64                 lastContentId_ = 0;
+    quint64                 playingContent_ = 0;    // repeated content from the cache
+    dao::ContentCacheStats  contentCacheStats_;
+    dao::LevelOfDetailStats lodStats_;              // last show with a target rate
+
+    bool                    isRecovering_ = false;
+    QElapsedTimer           recoveryTimer_;
+    int                     reconnectDelay_ = 0;  // ms
+    cflib::util::EVTimer    reconnectTimer_;
+    DeviceWatcher           deviceWatcher_;
+    dao::RecoveryStats      recoveryStats_;
+
     bool                    isActive_ = false;
     cflib::util::EVTimer    readyTimer_;
+    qint64                  expectedCheck_ = -1;  // us
+    dao::TimerStats         timerStats_;
     QList<EasyLase::Points> pointQueue_;
     bool                    isRepeating_ = false;
     int                     repeatPos_ = 0;
-    VoidFunc                finishedCallback_;
-    int                     finishedCallQueueSize_ = -1;
+    QList<Source>           sources_;
+    qsizetype               remainingPoints_ = 0;
+    bool                    needsPlaceholder_ = false;
+    bool                    hasPlaceholder_ = false;
+    FinishFunc              finishedCallback_;
+    int                     finishedLead_ = DefaultFinishedLead;
+    bool                    isFinishedArmed_ = false;
+    cflib::util::EVTimer    finishedTimer_;
+
+    bool                    isStreaming_ = false;
+    quint16                 streamPps_ = MaxSpeed;
+    Points                  streamRecord_;
+    bool                    isStreamRecorded_ = false;
+    EasyLase::Points        pendingRepeat_;
+
+    std::shared_ptr<ShmRing> ring_;
+
+    FrameFanout             fanout_;
+    quint64                 frameSeq_ = 0;
+
+    bool                    isSeamless_ = false;
+    bool                    isBlankedSwitch_ = false;
+    bool                    isSwitching_ = false;
+    QElapsedTimer           switchTimer_;
+    double                  switchLatency_ = 0.0;
+    EasyLase::Point         lastPoint_;
+    int                     lastFrameSize_ = 0;
+
+    DeviceClock             deviceClock_;
+    bool                    wasFull_ = false;
+    qint64                  lastPoll_ = 0;
+    QList<Timed>            timed_;
+    cflib::util::EVTimer    timedTimer_;
+    bool                    isTimedDue_ = false;
+    bool                    isTimedSwitch_ = false;
+    qint64                  timedTarget_ = -1;
+    TimeFunc                presentedCallback_;
+
+    Cues                    cues_;              // device points since content began
+    qsizetype               contentEnd_ = 0;    // device points of content enqueued
+    qsizetype               submittedPos_ = 0;  // device points of content submitted
+    QList<ScheduledCue>     scheduledCues_;
+    cflib::util::EVTimer    cueTimer_;
+    CueFunc                 cueCallback_;
 };
@@ -0,0 +1,198 @@
+#include "levelofdetail.h"
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+using dao::LaserPoint;
+using dao::LaserPoints;
+
+namespace {
+
+inline bool sameColor(const LaserPoint & a, const LaserPoint & b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+inline bool isSame(const LaserPoint & a, const LaserPoint & b) { return a.x == b.x && a.y == b.y && sameColor(a, b); }
+inline bool isLit(const LaserPoint & p) { return p.r || p.g || p.b; }
+
+struct Segment
+{
+    int   begin;
+    int   end;     // exclusive
+    float extent;  // diagonal of the bounding box
+};
+
+// Plain loops over separate arrays, so the compiler can vectorize them.
+void segmentDistances(const float * x, const float * y, float * dist, int count, float ax, float ay, float bx, float by)
+{
+    const float dx   = bx - ax;
+    const float dy   = by - ay;
+    const float len2 = dx * dx + dy * dy;
+    const float inv  = len2 > 0.0f ? 1.0f / len2 : 0.0f;
+    for (int i = 0 ; i < count ; ++i) {
+        const float px = x[i] - ax;
+        const float py = y[i] - ay;
+        const float t  = std::clamp((px * dx + py * dy) * inv, 0.0f, 1.0f);
+        const float ex = px - t * dx;
+        const float ey = py - t * dy;
+        dist[i] = ex * ex + ey * ey;
+    }
+}
+
+int maxIndex(const float * dist, int count)
+{
+    int rv = 0;
+    for (int i = 1 ; i < count ; ++i) if (dist[i] > dist[rv]) rv = i;
+    return rv;
+}
+
+// Douglas-Peucker for all tolerances at once: a point is kept for tolerance e, if its importance is above e.
+// The importance of a split point is capped by the one of its parent, so that the kept points are the same
+// as with a plain Douglas-Peucker run.
+void importances(const float * x, const float * y, int begin, int end, float * importance, float * dist)
+{
+    struct Span { int a; int b; float cap; };
+    QVector<Span> stack{ Span{ begin, end - 1, std::numeric_limits<float>::max() } };
+    while (!stack.isEmpty()) {
+        const Span s = stack.takeLast();
+        const int count = s.b - s.a - 1;
+        if (count <= 0) continue;
+        segmentDistances(x + s.a + 1, y + s.a + 1, dist, count, x[s.a], y[s.a], x[s.b], y[s.b]);
+        const int   i = s.a + 1 + maxIndex(dist, count);
+        const float d = qMin(std::sqrt(dist[i - s.a - 1]), s.cap);
+        importance[i] = d;
+        stack << Span{ s.a, i, d } << Span{ i, s.b, d };
+    }
+}
+
+}
+
+LevelOfDetail::Result LevelOfDetail::simplify(const LaserPoints & input, int pointBudget) const
+{
+    Result rv{ .points = input };
+    if (pointBudget <= 0 || input.size() <= pointBudget) return rv;
+
+    // dwell: keep as many repeated points as fit, at least one of each
+    QVector<int> runs;
+    for (int i = 0 ; i < input.size() ; ++i) {
+        if (i > 0 && isSame(input[i], input[i - 1])) ++runs.last();
+        else                                         runs << 1;
+    }
+    int lo = 1;
+    int hi = *std::max_element(runs.cbegin(), runs.cend());
+    while (lo < hi) {
+        const int cap = (lo + hi + 1) / 2;
+        qsizetype count = 0;
+        for (int run : runs) count += qMin(run, cap);
+        if (count <= pointBudget) lo = cap;
+        else                      hi = cap - 1;
+    }
+    LaserPoints points;
+    QVector<bool> isDwell;
+    points.reserve(input.size());
+    for (int i = 0, r = 0 ; r < runs.size() ; i += runs[r++]) {
+        for (int k = qMin(runs[r], lo) ; k > 0 ; --k) {
+            points  << input[i];
+            isDwell << (runs[r] > 1);
+        }
+    }
+    if (points.size() <= pointBudget) {
+        rv.points = points;
+        logTrace("reduced dwell of %1 points to %2", input.size(), points.size());
+        return rv;
+    }
+
+    // sub-visible lit segments, smallest first
+    // dots and dwelled runs are deliberate and stay
+    QVector<Segment> segments;
+    for (int i = 0 ; i < points.size() ; ) {
+        if (!isLit(points[i])) {
+            ++i;
+            continue;
+        }
+        Segment seg{ .begin = i, .end = i, .extent = 0.0f };
+        float minX = points[i].x, maxX = minX, minY = points[i].y, maxY = minY;
+        bool hasDwell = false;
+        for ( ; seg.end < points.size() && isLit(points[seg.end]) ; ++seg.end) {
+            minX = qMin(minX, (float)points[seg.end].x);
+            maxX = qMax(maxX, (float)points[seg.end].x);
+            minY = qMin(minY, (float)points[seg.end].y);
+            maxY = qMax(maxY, (float)points[seg.end].y);
+            hasDwell = hasDwell || isDwell[seg.end];
+        }
+        seg.extent = std::hypot(maxX - minX, maxY - minY);
+        const bool isAll = seg.begin == 0 && seg.end == points.size();
+        if (seg.extent > 0.0f && seg.extent < config_.minSegment && !hasDwell && !isAll) segments << seg;
+        i = seg.end;
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment & a, const Segment & b) { return a.extent < b.extent; });
+    QVector<bool> isDropped(points.size(), false);
+    qsizetype count = points.size();
+    for (const Segment & seg : segments) {
+        if (count <= pointBudget) break;
+        for (int i = seg.begin ; i < seg.end ; ++i) isDropped[i] = true;
+        count -= seg.end - seg.begin;
+        ++rv.droppedRuns;
+
+        // a dropped run deviates by its extent at least, or by its distance to the blank jump that replaces it
+        const LaserPoint & a = points[seg.begin > 0             ? seg.begin - 1 : seg.end      ];
+        const LaserPoint & b = points[seg.end < points.size() ? seg.end       : seg.begin - 1];
+        const int len = seg.end - seg.begin;
+        QVector<float> xs(len), ys(len), dist(len);
+        for (int i = 0 ; i < len ; ++i) {
+            xs[i] = points[seg.begin + i].x;
+            ys[i] = points[seg.begin + i].y;
+        }
+        segmentDistances(xs.constData(), ys.constData(), dist.data(), len, a.x, a.y, b.x, b.y);
+        rv.error = qMax(rv.error, (double)qMax(seg.extent, std::sqrt(dist[maxIndex(dist.constData(), len)])));
+    }
+    if (rv.droppedRuns > 0) {
+        LaserPoints kept;
+        kept.reserve(count);
+        for (int i = 0 ; i < points.size() ; ++i) if (!isDropped[i]) kept << points[i];
+        points = kept;
+    }
+    if (points.size() <= pointBudget) {
+        rv.points = points;
+        logTrace("dropped %1 sub-visible segments, %2 of %3 points left", rv.droppedRuns, points.size(), input.size());
+        return rv;
+    }
+
+    // Douglas-Peucker within lit runs of one color, blank runs are travel of the galvos
+    const int n = points.size();
+    QVector<float> xs(n), ys(n), dist(n);
+    for (int i = 0 ; i < n ; ++i) {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
+    QVector<float> importance(n, std::numeric_limits<float>::max());
+    int free = pointBudget;
+    for (int begin = 0 ; begin < n ; ) {
+        int end = begin + 1;
+        while (end < n && sameColor(points[end], points[begin])) ++end;
+        if (isLit(points[begin])) {
+            importances(xs.constData(), ys.constData(), begin, end, importance.data(), dist.data());
+            free -= qMin(end - begin, 2);
+        } else {
+            free -= end - begin;
+        }
+        begin = end;
+    }
+
+    // smallest tolerance that fits the budget
+    QVector<float> sorted;
+    for (float imp : importance) if (imp < std::numeric_limits<float>::max()) sorted << imp;
+    float tolerance = -1.0f;
+    if (free < sorted.size()) {
+        const int pos = qMax(0, free);
+        std::nth_element(sorted.begin(), sorted.begin() + pos, sorted.end(), std::greater<float>());
+        tolerance = qMin(sorted[pos], (float)config_.maxError);
+    }
+
+    LaserPoints kept;
+    kept.reserve(qMin(n, pointBudget));
+    for (int i = 0 ; i < n ; ++i) if (importance[i] > tolerance) kept << points[i];
+    rv.points = kept;
+    rv.error  = qMax(rv.error, (double)qMax(0.0f, tolerance));
+
+    logTrace("simplified %1 points to %2 (budget %3, error %4)", input.size(), kept.size(), pointBudget, rv.error);
+    return rv;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <dao/laserpoint.h>
+
+// Simplifies the geometry of a frame until it fits a point budget, with as little error as possible:
+// dwell points are reduced first, then sub-visible lit segments are dropped (smallest first, but never
+// dots or dwelled runs), at last lit runs of one color are simplified Douglas-Peucker style.
+// Ends of lit runs are kept, so color changes stay exact. Blank runs are left as they are.
+// Lines lose their interpolation points, the result has to be resampled before it is shown.
+class LevelOfDetail
+{
+public:
+    struct Config
+    {
+        double minSegment = 0.004;  // lit segments with a smaller extent are not visible (full range = 2.0)
+        double maxError   = 0.05;   // largest deviation allowed for Douglas-Peucker
+    };
+
+    struct Result
+    {
+        dao::LaserPoints points;
+        double           error       = 0.0;  // max deviation from the input
+        int              droppedRuns = 0;    // sub-visible lit runs that are not shown
+    };
+
+public:
+    LevelOfDetail() = default;
+    LevelOfDetail(const Config & config) : config_(config) {}
+
+    const Config & config() const { return config_; }
+
+    // The result may exceed the budget, if maxError does not allow to reach it.
+    Result simplify(const dao::LaserPoints & points, int pointBudget) const;
+
+private:
+    Config config_;
+};
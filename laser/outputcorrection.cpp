@@ -0,0 +1,242 @@
+#include "outputcorrection.h"
+
+#include <laser/laser.h>
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+namespace {
+
+constexpr int Block = 256;  // points transformed at once
+
+inline quint16 toDevice(double v) { return qBound(0, qRound((v + 1.0) * 2047.5), 4095); }
+
+inline quint16 fixedToDevice(qint16 v) { return qBound(0, (int)((v + 16384) * 4095 + 16384) / 32768, 4095); }
+
+struct DevicePointSource
+{
+    const EasyLase::Point * points;
+    double x(qsizetype i) const { return points[i].x / 2047.5 - 1.0; }
+    double y(qsizetype i) const { return points[i].y / 2047.5 - 1.0; }
+    quint8 r(qsizetype i) const { return points[i].r; }
+    quint8 g(qsizetype i) const { return points[i].g; }
+    quint8 b(qsizetype i) const { return points[i].b; }
+};
+
+bool isInRange(const qint16 * xs, const qint16 * ys, qsizetype count)
+{
+    int lo = 0;
+    int hi = 0;
+    for (qsizetype i = 0 ; i < count ; ++i) {
+        lo = qMin(lo, qMin<int>(xs[i], ys[i]));
+        hi = qMax(hi, qMax<int>(xs[i], ys[i]));
+    }
+    return lo >= -16384 && hi <= 16384;
+}
+
+}
+
+OutputCorrection::OutputCorrection() :
+    OutputCorrection(dao::CorrectionConfig())
+{
+}
+
+OutputCorrection::OutputCorrection(const dao::CorrectionConfig & config) :
+    matrix_{ 1, 0, 0, 0, 1, 0, 0, 0, 1 },
+    left_  (qBound(-1.0, config.left,   1.0)),
+    bottom_(qBound(-1.0, config.bottom, 1.0)),
+    right_ (qBound(-1.0, config.right,  1.0)),
+    top_   (qBound(-1.0, config.top,    1.0)),
+    hasColorLut_(false),
+    hasIntensity_(false)
+{
+    bool isIdentityMatrix = true;
+    if (config.matrix.size() == 9) {
+        for (int i = 0 ; i < 9 ; ++i) matrix_[i] = config.matrix[i];
+        isIdentityMatrix = config.matrix == QVector<double>{ 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+    } else if (!config.matrix.isEmpty()) {
+        logWarn("ignoring transformation matrix with %1 elements", config.matrix.size());
+    }
+
+    const QVector<quint8> * luts[4] = { &config.red, &config.green, &config.blue, &config.intensity };
+    for (int c = 0 ; c < 4 ; ++c) {
+        Lut & lut = lut_[c];
+        for (int i = 0 ; i < 256 ; ++i) lut[i] = i;
+        if (luts[c]->isEmpty()) continue;
+        if (luts[c]->size() != 256) {
+            logWarn("ignoring color lookup table with %1 entries", luts[c]->size());
+            continue;
+        }
+        for (int i = 0 ; i < 256 ; ++i) lut[i] = (*luts[c])[i];
+        if (c < 3) hasColorLut_  = true;
+        else       hasIntensity_ = true;
+    }
+
+    isIdentity_ = isIdentityMatrix && !hasColorLut_ && !hasIntensity_ &&
+        left_ == -1.0 && bottom_ == -1.0 && right_ == 1.0 && top_ == 1.0;
+}
+
+EasyLase::Points OutputCorrection::convert(const PointView & points, quint16 pps) const
+{
+    EasyLase::Points rv;
+    convert(points, 0, points.size(), pps, rv);
+    return rv;
+}
+
+void OutputCorrection::convert(const PointView & points, qsizetype begin, qsizetype count, quint16 pps,
+    EasyLase::Points & out) const
+{
+    const int replication = Laser::replication(pps);
+    out.reserve(out.size() + count * replication);
+
+    // plain conversion if nothing needs to be clipped
+    const qint16 * xs = points.xData();
+    const qint16 * ys = points.yData();
+    if (isIdentity_ && isInRange(xs + begin, ys + begin, count)) {
+        for (qsizetype i = begin ; i < begin + count ; ++i) {
+            const EasyLase::Point ep{
+                .x = fixedToDevice(xs[i]),
+                .y = fixedToDevice(ys[i]),
+                .r = points.r(i),
+                .g = points.g(i),
+                .b = points.b(i)
+            };
+            for (int j = 0 ; j < replication ; ++j) out << ep;
+        }
+        return;
+    }
+    process(points, begin, begin + count, replication, out);
+}
+
+EasyLase::Points OutputCorrection::correct(const EasyLase::Points & points) const
+{
+    if (isIdentity_) return points;
+    EasyLase::Points rv;
+    rv.reserve(points.size() + points.size() / 16);
+    process(DevicePointSource{ points.constData() }, 0, points.size(), 1, rv);
+    return rv;
+}
+
+EasyLase::Points OutputCorrection::correct(const EasyLase::Point * points, qsizetype count) const
+{
+    if (isIdentity_) return EasyLase::Points(points, points + count);
+    EasyLase::Points rv;
+    rv.reserve(count + count / 16);
+    process(DevicePointSource{ points }, 0, count, 1, rv);
+    return rv;
+}
+
+// Liang-Barsky: visible part [t0, t1] of segment (x, y) + t * (dx, dy)
+bool OutputCorrection::clip(double x, double y, double dx, double dy, double & t0, double & t1) const
+{
+    t0 = 0.0;
+    t1 = 1.0;
+    auto edge = [&](double p, double q) {
+        if (p == 0.0) return q >= 0.0;
+        const double r = q / p;
+        if (p < 0.0) {
+            if (r > t1) return false;
+            if (r > t0) t0 = r;
+        } else {
+            if (r < t0) return false;
+            if (r < t1) t1 = r;
+        }
+        return true;
+    };
+    return edge(-dx, x - left_) && edge(dx, right_ - x) && edge(-dy, y - bottom_) && edge(dy, top_ - y);
+}
+
+template<typename Source>
+void OutputCorrection::process(const Source & source, qsizetype begin, qsizetype end, int replication,
+    EasyLase::Points & rv) const
+{
+    auto append = [&](double x, double y, quint8 r, quint8 g, quint8 b) {
+        EasyLase::Point p{ .x = toDevice(x), .y = toDevice(y) };
+        // blanked points stay dark whatever the tables say
+        if (r || g || b) {
+            p.r = lut_[0][r];
+            p.g = lut_[1][g];
+            p.b = lut_[2][b];
+            if (hasIntensity_) p.i = lut_[3][qMax(r, qMax(g, b))];
+        }
+        for (int i = 0 ; i < replication ; ++i) rv << p;
+    };
+    auto appendBlank = [&](double x, double y) {
+        append(qBound(left_, x, right_), qBound(bottom_, y, top_), 0, 0, 0);
+    };
+
+    double xs[Block];
+    double ys[Block];
+    bool   valid[Block];
+
+    // projective transform, free of branches
+    auto transform = [&](qsizetype base, int n) {
+        for (int i = 0 ; i < n ; ++i) {
+            const double x = source.x(base + i);
+            const double y = source.y(base + i);
+            const double w = matrix_[6] * x + matrix_[7] * y + matrix_[8];
+            valid[i] = w > 0.0;
+            const double iw = valid[i] ? 1.0 / w : 0.0;
+            xs[i] = (matrix_[0] * x + matrix_[1] * y + matrix_[2]) * iw;
+            ys[i] = (matrix_[3] * x + matrix_[4] * y + matrix_[5]) * iw;
+        }
+    };
+
+    bool   hasPrev     = false;
+    bool   prevInside  = false;
+    double prevX       = 0.0;
+    double prevY       = 0.0;
+
+    // segment from preceding point gets clipped correctly
+    if (begin > 0) {
+        transform(begin - 1, 1);
+        hasPrev    = valid[0];
+        prevX      = xs[0];
+        prevY      = ys[0];
+        prevInside = valid[0] && prevX >= left_ && prevX <= right_ && prevY >= bottom_ && prevY <= top_;
+    }
+
+    for (qsizetype base = begin ; base < end ; base += Block) {
+        const int n = qMin<qsizetype>(Block, end - base);
+        transform(base, n);
+
+        // clipping, color and quantization
+        for (int i = 0 ; i < n ; ++i) {
+            const quint8 r = source.r(base + i);
+            const quint8 g = source.g(base + i);
+            const quint8 b = source.b(base + i);
+            const double x = xs[i];
+            const double y = ys[i];
+            const bool inside = valid[i] && x >= left_ && x <= right_ && y >= bottom_ && y <= top_;
+
+            if (inside && (prevInside || !hasPrev)) {
+                append(x, y, r, g, b);
+            } else if (!hasPrev || !valid[i]) {
+                appendBlank(x, y);
+            } else {
+                const double dx = x - prevX;
+                const double dy = y - prevY;
+                double t0, t1;
+                if (!clip(prevX, prevY, dx, dy, t0, t1)) {
+                    appendBlank(x, y);
+                } else {
+                    // move blanked to entry point
+                    if (t0 > 0.0) appendBlank(prevX + t0 * dx, prevY + t0 * dy);
+                    if (t1 < 1.0) {
+                        // draw until leaving the viewport
+                        append(prevX + t1 * dx, prevY + t1 * dy, r, g, b);
+                        appendBlank(prevX + t1 * dx, prevY + t1 * dy);
+                    } else {
+                        append(x, y, r, g, b);
+                    }
+                }
+            }
+
+            hasPrev    = valid[i];
+            prevInside = inside;
+            prevX      = x;
+            prevY      = y;
+        }
+    }
+}
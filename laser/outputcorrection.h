@@ -0,0 +1,49 @@
+#pragma once
+
+#include <dao/correctionconfig.h>
+#include <laser/easylase.h>
+#include <laser/pointbuffer.h>
+
+// Projective transform, viewport clipping and color lookup tables.
+// All of it is done in the same pass which produces the device points.
+class OutputCorrection
+{
+public:
+    OutputCorrection();
+    OutputCorrection(const dao::CorrectionConfig & config);
+
+    // Same as Laser::convert(...), but with correction.
+    EasyLase::Points convert(const PointView & points, quint16 pps) const;
+
+    // Converts count points starting at begin and appends them to out.
+    // Clipping may add some points.
+    void convert(const PointView & points, qsizetype begin, qsizetype count, quint16 pps,
+        EasyLase::Points & out) const;
+
+    // Corrects points which are already in device format.
+    EasyLase::Points correct(const EasyLase::Points & points) const;
+    EasyLase::Points correct(const EasyLase::Point * points, qsizetype count) const;
+
+    // no transformation, default viewport and no lookup tables
+    bool isIdentity() const { return isIdentity_; }
+
+private:
+    template<typename Source>
+    void process(const Source & source, qsizetype begin, qsizetype end, int replication,
+        EasyLase::Points & out) const;
+
+    bool clip(double x, double y, double dx, double dy, double & t0, double & t1) const;
+
+private:
+    using Lut = std::array<quint8, 256>;
+
+    double matrix_[9];
+    double left_;
+    double bottom_;
+    double right_;
+    double top_;
+    Lut    lut_[4];       // r, g, b, i
+    bool   hasColorLut_;
+    bool   hasIntensity_;
+    bool   isIdentity_;
+};
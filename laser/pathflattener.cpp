@@ -0,0 +1,249 @@
+#include "pathflattener.h"
+
+#include <laser/laser.h>
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+using dao::LaserPath;
+using dao::LaserPoint;
+using dao::LaserPoints;
+using dao::PathSegment;
+
+namespace {
+
+constexpr double    Pi            = std::numbers::pi_v<double>;
+constexpr qsizetype MaxPoints     = Laser::StreamRepeatLimit;  // per path, more could not be shown anyway
+constexpr double    MaxSteps      = MaxPoints;                 // per segment
+constexpr double    MaxCoordinate = 8.0;                       // full range is 2.0, far outside is an error
+
+size_t hashPath(const LaserPath & path)
+{
+    size_t rv = 0;
+    for (const PathSegment & s : path) {
+        rv = qHashMulti(rv, s.type, s.x, s.y, s.x1, s.y1, s.x2, s.y2, s.largeArc, s.sweep, s.r, s.g, s.b);
+    }
+    return rv;
+}
+
+bool isSame(const PathSegment & a, const PathSegment & b)
+{
+    return a.type == b.type && a.x  == b.x  && a.y  == b.y  && a.x1 == b.x1 && a.y1 == b.y1 &&
+        a.x2 == b.x2 && a.y2 == b.y2 && a.largeArc == b.largeArc && a.sweep == b.sweep &&
+        a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+inline bool isInRange(double v) { return std::isfinite(v) && qAbs(v) <= MaxCoordinate; }
+
+// radii and rotation of arcs only have to be finite
+bool isInRange(const LaserPath & path)
+{
+    for (const PathSegment & s : path) {
+        if (!isInRange(s.x) || !isInRange(s.y)) return false;
+        if (s.type == PathSegment::Arc) {
+            if (!std::isfinite(s.x1) || !std::isfinite(s.y1) || !std::isfinite(s.x2)) return false;
+        } else {
+            if (!isInRange(s.x1) || !isInRange(s.y1) || !isInRange(s.x2) || !isInRange(s.y2)) return false;
+        }
+    }
+    return true;
+}
+
+bool isSame(const LaserPath & a, const LaserPath & b)
+{
+    if (a.size() != b.size()) return false;
+    for (qsizetype i = 0 ; i < a.size() ; ++i) if (!isSame(a[i], b[i])) return false;
+    return true;
+}
+
+// Evaluation kernels work on separate arrays (t -> x, y),
+// so that the compiler can vectorize them.
+
+struct Cubic { double x0, y0, x1, y1, x2, y2, x3, y3; };
+
+void evalCubic(const Cubic & c, const double * t, double * x, double * y, int count)
+{
+    for (int i = 0 ; i < count ; ++i) {
+        const double s  = t[i];
+        const double u  = 1.0 - s;
+        const double b0 = u * u * u;
+        const double b1 = 3.0 * u * u * s;
+        const double b2 = 3.0 * u * s * s;
+        const double b3 = s * s * s;
+        x[i] = b0 * c.x0 + b1 * c.x1 + b2 * c.x2 + b3 * c.x3;
+        y[i] = b0 * c.y0 + b1 * c.y1 + b2 * c.y2 + b3 * c.y3;
+    }
+}
+
+struct Ellipse { double cx, cy, rx, ry, cosPhi, sinPhi, theta, delta; };
+
+void evalArc(const Ellipse & e, const double * t, double * x, double * y, int count)
+{
+    for (int i = 0 ; i < count ; ++i) {
+        const double a  = e.theta + e.delta * t[i];
+        const double ex = e.rx * std::cos(a);
+        const double ey = e.ry * std::sin(a);
+        x[i] = e.cx + ex * e.cosPhi - ey * e.sinPhi;
+        y[i] = e.cy + ex * e.sinPhi + ey * e.cosPhi;
+    }
+}
+
+// Wang's formula: uniform subdivision count keeping the chord error below tolerance.
+int cubicSteps(const Cubic & c, double tolerance, double maxStep)
+{
+    const double d1 = std::hypot(c.x0 - 2 * c.x1 + c.x2, c.y0 - 2 * c.y1 + c.y2);
+    const double d2 = std::hypot(c.x1 - 2 * c.x2 + c.x3, c.y1 - 2 * c.y2 + c.y3);
+    const double length =
+        std::hypot(c.x1 - c.x0, c.y1 - c.y0) +
+        std::hypot(c.x2 - c.x1, c.y2 - c.y1) +
+        std::hypot(c.x3 - c.x2, c.y3 - c.y2);
+    const double byError  = std::ceil(std::sqrt(0.75 * qMax(d1, d2) / tolerance));
+    const double byLength = std::ceil(length / maxStep);
+    return (int)qBound(1.0, qMax(byError, byLength), MaxSteps);
+}
+
+// SVG endpoint to center parameterization
+bool toEllipse(double x0, double y0, const PathSegment & s, Ellipse & e)
+{
+    double rx = qAbs(s.x1);
+    double ry = qAbs(s.y1);
+    if (rx == 0.0 || ry == 0.0 || (x0 == s.x && y0 == s.y)) return false;
+
+    e.cosPhi = std::cos(s.x2);
+    e.sinPhi = std::sin(s.x2);
+    const double dx  = (x0 - s.x) / 2;
+    const double dy  = (y0 - s.y) / 2;
+    const double x1p =  e.cosPhi * dx + e.sinPhi * dy;
+    const double y1p = -e.sinPhi * dx + e.cosPhi * dy;
+
+    const double lambda = (x1p * x1p) / (rx * rx) + (y1p * y1p) / (ry * ry);
+    if (lambda > 1.0) {
+        rx *= std::sqrt(lambda);
+        ry *= std::sqrt(lambda);
+    }
+    const double num  = rx * rx * ry * ry - rx * rx * y1p * y1p - ry * ry * x1p * x1p;
+    const double den  = rx * rx * y1p * y1p + ry * ry * x1p * x1p;
+    const double coef = std::sqrt(qMax(0.0, num / den)) * (s.largeArc == s.sweep ? -1.0 : 1.0);
+    const double cxp  =  coef * rx * y1p / ry;
+    const double cyp  = -coef * ry * x1p / rx;
+
+    e.cx = e.cosPhi * cxp - e.sinPhi * cyp + (x0 + s.x) / 2;
+    e.cy = e.sinPhi * cxp + e.cosPhi * cyp + (y0 + s.y) / 2;
+    e.rx = rx;
+    e.ry = ry;
+
+    const double ux = ( x1p - cxp) / rx, uy = ( y1p - cyp) / ry;
+    const double vx = (-x1p - cxp) / rx, vy = (-y1p - cyp) / ry;
+    e.theta = std::atan2(uy, ux);
+    e.delta = std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+    if (!s.sweep && e.delta > 0.0) e.delta -= 2 * Pi;
+    if ( s.sweep && e.delta < 0.0) e.delta += 2 * Pi;
+    return true;
+}
+
+int arcSteps(const Ellipse & e, double tolerance, double maxStep)
+{
+    const double r = qMax(e.rx, e.ry);
+    const double maxAngle = tolerance < r ? 2 * std::acos(1.0 - tolerance / r) : Pi / 2;
+    const double byError  = std::ceil(qAbs(e.delta) / maxAngle);
+    const double byLength = std::ceil(qAbs(e.delta) * r / maxStep);
+    return (int)qBound(1.0, qMax(byError, byLength), MaxSteps);
+}
+
+}
+
+LaserPoints PathFlattener::flatten(const LaserPath & path)
+{
+    if (!isInRange(path)) {
+        logWarn("ignoring path with non-finite or out of range coordinates");
+        return LaserPoints();
+    }
+
+    const size_t hash = hashPath(path);
+    for (qsizetype i = 0 ; i < cache_.size() ; ++i) {
+        if (cache_[i].hash != hash || !isSame(cache_[i].path, path)) continue;
+        ++cacheHits_;
+        if (i > 0) cache_.move(i, 0);
+        return cache_.first().points;
+    }
+
+    ++cacheMisses_;
+    LaserPoints rv;
+    if (!flattenUncached(path, rv)) {
+        logWarn("ignoring path with more than %1 points", MaxPoints);
+        return LaserPoints();
+    }
+    cache_.prepend(CacheEntry{ hash, path, rv });
+    while (cache_.size() > config_.cacheSize) cache_.removeLast();
+    logDebug("flattened path with %1 segments to %2 points (cache hits: %3, misses: %4)",
+        path.size(), rv.size(), cacheHits_, cacheMisses_);
+    return rv;
+}
+
+bool PathFlattener::flattenUncached(const LaserPath & path, LaserPoints & rv) const
+{
+    QVector<double> ts, xs, ys;
+    double penX = 0.0;
+    double penY = 0.0;
+
+    for (const PathSegment & s : path) {
+        if (rv.size() + 2 > MaxPoints) return false;
+        if (s.type == PathSegment::Move) {
+            if (!rv.isEmpty() && (rv.last().r || rv.last().g || rv.last().b)) rv << LaserPoint{ .x = penX, .y = penY };
+            penX = s.x;
+            penY = s.y;
+            rv << LaserPoint{ .x = penX, .y = penY };
+            continue;
+        }
+
+        int steps = 0;
+        Cubic   cubic;
+        Ellipse ellipse;
+        bool    isArc = false;
+        switch (s.type) {
+        case PathSegment::Quad:
+            cubic = Cubic{ penX, penY,
+                penX + 2.0 / 3.0 * (s.x1 - penX), penY + 2.0 / 3.0 * (s.y1 - penY),
+                s.x  + 2.0 / 3.0 * (s.x1 - s.x ), s.y  + 2.0 / 3.0 * (s.y1 - s.y ),
+                s.x, s.y };
+            break;
+        case PathSegment::Cubic:
+            cubic = Cubic{ penX, penY, s.x1, s.y1, s.x2, s.y2, s.x, s.y };
+            break;
+        case PathSegment::Arc:
+            isArc = toEllipse(penX, penY, s, ellipse);
+            if (isArc) break;
+            [[fallthrough]];
+        default:
+            cubic = Cubic{ penX, penY,
+                penX + (s.x - penX) / 3.0, penY + (s.y - penY) / 3.0,
+                s.x  + (penX - s.x) / 3.0, s.y  + (penY - s.y) / 3.0,
+                s.x, s.y };
+            break;
+        }
+        steps = isArc ?
+            arcSteps  (ellipse, config_.tolerance, config_.maxStep) :
+            cubicSteps(cubic,   config_.tolerance, config_.maxStep);
+        if (rv.size() + steps + 1 > MaxPoints) return false;
+
+        ts.resize(steps);
+        xs.resize(steps);
+        ys.resize(steps);
+        for (int i = 0 ; i < steps ; ++i) ts[i] = (double)(i + 1) / steps;
+        if (isArc) evalArc  (ellipse, ts.constData(), xs.data(), ys.data(), steps);
+        else       evalCubic(cubic,   ts.constData(), xs.data(), ys.data(), steps);
+
+        // beam gets switched on (or changes color) at the start point
+        if (rv.isEmpty() || rv.last().r != s.r || rv.last().g != s.g || rv.last().b != s.b) {
+            rv << LaserPoint{ .x = penX, .y = penY, .r = s.r, .g = s.g, .b = s.b };
+        }
+        // exact end point
+        xs[steps - 1] = s.x;
+        ys[steps - 1] = s.y;
+        for (int i = 0 ; i < steps ; ++i) rv << LaserPoint{ .x = xs[i], .y = ys[i], .r = s.r, .g = s.g, .b = s.b };
+        penX = s.x;
+        penY = s.y;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <dao/laserpath.h>
+#include <dao/laserpoint.h>
+
+// Flattens vector paths into points. Curves are subdivided, so that the deviation
+// stays below tolerance and neighbouring points are not further apart than maxStep.
+// Paths with non-finite or far out of range coordinates give no points, as well as paths that would need
+// more points than Laser::StreamRepeatLimit.
+// Results are cached by path content.
+// This class has no threading.
+class PathFlattener
+{
+public:
+    struct Config
+    {
+        double tolerance = 0.001;  // max distance between curve and chord
+        double maxStep   = 0.01;   // max distance between two lit points
+        int    cacheSize = 64;     // number of cached paths
+    };
+
+public:
+    PathFlattener() = default;
+    PathFlattener(const Config & config) : config_(config) {}
+
+    dao::LaserPoints flatten(const dao::LaserPath & path);
+
+    int cacheHits()   const { return cacheHits_;   }
+    int cacheMisses() const { return cacheMisses_; }
+
+private:
+    bool flattenUncached(const dao::LaserPath & path, dao::LaserPoints & points) const;  // false: too many points
+
+private:
+    struct CacheEntry
+    {
+        size_t           hash;
+        dao::LaserPath   path;
+        dao::LaserPoints points;
+    };
+
+    Config            config_;
+    QList<CacheEntry> cache_;  // most recently used first
+    int               cacheHits_   = 0;
+    int               cacheMisses_ = 0;
+};
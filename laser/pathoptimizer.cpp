@@ -0,0 +1,176 @@
+#include "pathoptimizer.h"
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+using dao::LaserPoint;
+using dao::LaserPoints;
+
+namespace {
+
+struct Segment
+{
+    int  begin;             // first point
+    int  end;               // last point (inclusive)
+    bool reversed = false;
+};
+
+inline bool isLit(const LaserPoint & p) { return p.r != 0 || p.g != 0 || p.b != 0; }
+
+inline LaserPoint blanked(LaserPoint p) { p.r = p.g = p.b = 0; return p; }
+
+inline double distance(const LaserPoint & a, const LaserPoint & b) { return std::hypot(a.x - b.x, a.y - b.y); }
+
+inline const LaserPoint & head(const LaserPoints & points, const Segment & s) { return points[s.reversed ? s.end   : s.begin]; }
+inline const LaserPoint & tail(const LaserPoints & points, const Segment & s) { return points[s.reversed ? s.begin : s.end  ]; }
+
+QVector<Segment> findSegments(const LaserPoints & points)
+{
+    QVector<Segment> rv;
+    int begin = -1;
+    for (int i = 0 ; i < points.size() ; ++i) {
+        if (isLit(points[i])) {
+            if (begin == -1) begin = i;
+        } else if (begin != -1) {
+            rv << Segment{ .begin = begin, .end = i - 1 };
+            begin = -1;
+        }
+    }
+    if (begin != -1) rv << Segment{ .begin = begin, .end = (int)points.size() - 1 };
+    return rv;
+}
+
+double jumpLength(const LaserPoints & points, const QVector<Segment> & segments, bool closed)
+{
+    double rv = 0.0;
+    for (int i = 1 ; i < segments.size() ; ++i) rv += distance(tail(points, segments[i - 1]), head(points, segments[i]));
+    if (closed) rv += distance(tail(points, segments.last()), head(points, segments.first()));
+    return rv;
+}
+
+// First segment stays first, so content start does not move.
+void orderGreedy(const LaserPoints & points, QVector<Segment> & segments, const QElapsedTimer & timer, qint64 budget)
+{
+    for (int i = 1 ; i < segments.size() ; ++i) {
+        if (timer.nsecsElapsed() > budget) return;
+
+        const LaserPoint & from = tail(points, segments[i - 1]);
+        int    best         = i;
+        bool   bestReversed = false;
+        double bestDist     = std::numeric_limits<double>::max();
+        for (int j = i ; j < segments.size() ; ++j) {
+            const Segment & s = segments[j];
+            double d = distance(from, points[s.begin]);
+            if (d < bestDist) { bestDist = d; best = j; bestReversed = false; }
+            d = distance(from, points[s.end]);
+            if (d < bestDist) { bestDist = d; best = j; bestReversed = true; }
+        }
+        std::swap(segments[i], segments[best]);
+        segments[i].reversed = bestReversed;
+    }
+}
+
+// Reversing the run i..j also reverses the direction of every segment inside it.
+void improveTwoOpt(const LaserPoints & points, QVector<Segment> & segments, bool closed,
+    const QElapsedTimer & timer, qint64 budget)
+{
+    const int n = segments.size();
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (int i = 1 ; i < n ; ++i) {
+            if (timer.nsecsElapsed() > budget) return;
+            for (int j = i ; j < n ; ++j) {
+                const LaserPoint & prevTail = tail(points, segments[i - 1]);
+                const bool hasNext = j + 1 < n || closed;
+                const LaserPoint & nextHead = head(points, segments[j + 1 < n ? j + 1 : 0]);
+
+                double before = distance(prevTail, head(points, segments[i]));
+                double after  = distance(prevTail, tail(points, segments[j]));
+                if (hasNext) {
+                    before += distance(tail(points, segments[j]), nextHead);
+                    after  += distance(head(points, segments[i]), nextHead);
+                }
+                if (after >= before - 1e-9) continue;
+
+                std::reverse(segments.begin() + i, segments.begin() + j + 1);
+                for (int k = i ; k <= j ; ++k) segments[k].reversed = !segments[k].reversed;
+                improved = true;
+            }
+        }
+    }
+}
+
+}
+
+LaserPoints PathOptimizer::optimize(const LaserPoints & points, quint16 pps, bool closed) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 budget = config_.timeBudget * 1e9;
+
+    QVector<Segment> segments = findSegments(points);
+    if (segments.isEmpty()) return points;
+
+    const double lengthBefore = jumpLength(points, segments, closed);
+    orderGreedy(points, segments, timer, budget);
+    improveTwoOpt(points, segments, closed, timer, budget);
+
+    const int    settle      = qRound(config_.settleTime * pps);
+    const double cornerLimit = config_.cornerAngle * std::numbers::pi / 180.0;
+
+    LaserPoints rv;
+    rv.reserve(points.size() + segments.size() * (4 * settle + 8));
+
+    auto jump = [&](const LaserPoint & fromLit, const LaserPoint & toLit) {
+        const LaserPoint from = blanked(fromLit);
+        const LaserPoint to   = blanked(toLit);
+        for (int i = 0 ; i < settle ; ++i) rv << from;
+        const int steps = std::ceil(distance(from, to) / config_.jumpSpeed * pps);
+        for (int i = 1 ; i < steps ; ++i) {
+            const double t = (double)i / steps;
+            rv << LaserPoint{ .x = from.x + (to.x - from.x) * t, .y = from.y + (to.y - from.y) * t };
+        }
+        for (int i = 0 ; i < settle ; ++i) rv << to;
+    };
+
+    auto cornerDwell = [&](const LaserPoint & prev, const LaserPoint & p, const LaserPoint & next) {
+        const double ax = p.x - prev.x, ay = p.y - prev.y;
+        const double bx = next.x - p.x, by = next.y - p.y;
+        const double la = std::hypot(ax, ay), lb = std::hypot(bx, by);
+        // repeated points are dwell the client already added
+        if (la == 0.0 || lb == 0.0) return 0;
+        const double angle = std::acos(qBound(-1.0, (ax * bx + ay * by) / (la * lb), 1.0));
+        if (angle < cornerLimit) return 0;
+        return qRound(config_.cornerTime * pps * angle / std::numbers::pi);
+    };
+
+    auto emitSegment = [&](const Segment & s) {
+        const int step  = s.reversed ? -1 : 1;
+        const int first = s.reversed ? s.end : s.begin;
+        const int count = s.end - s.begin + 1;
+        for (int k = 0 ; k < count ; ++k) {
+            const LaserPoint & p = points[first + k * step];
+            rv << p;
+            if (k == 0 || k == count - 1) continue;
+            const int dwell = cornerDwell(points[first + (k - 1) * step], p, points[first + (k + 1) * step]);
+            for (int i = 0 ; i < dwell ; ++i) rv << p;
+        }
+        const LaserPoint & last = points[first + (count - 1) * step];
+        for (int i = 0 ; i < settle ; ++i) rv << last;
+    };
+
+    if (!closed) jump(head(points, segments.first()), head(points, segments.first()));
+    emitSegment(segments.first());
+    for (int i = 1 ; i < segments.size() ; ++i) {
+        jump(tail(points, segments[i - 1]), head(points, segments[i]));
+        emitSegment(segments[i]);
+    }
+    if (closed) jump(tail(points, segments.last()), head(points, segments.first()));
+
+    logDebug("optimized %1 segments in %2us, jump length: %3 -> %4, points: %5 -> %6",
+        segments.size(), timer.nsecsElapsed() / 1000, lengthBefore, jumpLength(points, segments, closed),
+        points.size(), rv.size());
+    return rv;
+}
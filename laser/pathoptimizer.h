@@ -0,0 +1,32 @@
+#pragma once
+
+#include <dao/laserpoint.h>
+
+// Splits input into lit segments and reorders / reverses them to minimize blanked travel.
+// Blank jumps and dwell points are generated from a simple galvo speed model.
+class PathOptimizer
+{
+public:
+    struct Config
+    {
+        bool   enabled     = false;
+        double jumpSpeed   = 1500.0;  // blanked travel in units per second (full range = 2.0)
+        double settleTime  = 0.0002;  // dwell in seconds at both ends of a blank jump
+        double cornerTime  = 0.0003;  // dwell in seconds for a 180 degree turn
+        double cornerAngle = 30.0;    // turns below this angle (degrees) get no dwell
+        double timeBudget  = 0.002;   // max seconds spent on reordering
+    };
+
+public:
+    PathOptimizer() = default;
+    PathOptimizer(const Config & config) : config_(config) {}
+
+    const Config & config() const { return config_; }
+    bool isEnabled() const { return config_.enabled; }
+
+    // closed: content is repeated, so the jump from last to first point is part of the path.
+    dao::LaserPoints optimize(const dao::LaserPoints & points, quint16 pps, bool closed) const;
+
+private:
+    Config config_;
+};
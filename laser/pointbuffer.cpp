@@ -0,0 +1,121 @@
+#include "pointbuffer.h"
+
+namespace {
+
+template<typename T>
+inline void appendRange(QVector<T> & dest, const T * src, qsizetype count)
+{
+    const qsizetype size = dest.size();
+    dest.resize(size + count);
+    std::copy_n(src, count, dest.data() + size);
+}
+
+}
+
+PointBuffer::PointBuffer(const dao::LaserPoints & points)
+{
+    reserve(points.size());
+    for (const dao::LaserPoint & p : points) append(p);
+}
+
+PointBuffer::PointBuffer(qsizetype count, const dao::LaserPoint & point) :
+    x_(count, toFixed(point.x)),
+    y_(count, toFixed(point.y)),
+    r_(count, point.r),
+    g_(count, point.g),
+    b_(count, point.b)
+{
+}
+
+void PointBuffer::clear()
+{
+    x_.clear();
+    y_.clear();
+    r_.clear();
+    g_.clear();
+    b_.clear();
+}
+
+void PointBuffer::reserve(qsizetype count)
+{
+    x_.reserve(count);
+    y_.reserve(count);
+    r_.reserve(count);
+    g_.reserve(count);
+    b_.reserve(count);
+}
+
+void PointBuffer::resize(qsizetype count)
+{
+    x_.resize(count);
+    y_.resize(count);
+    r_.resize(count);
+    g_.resize(count);
+    b_.resize(count);
+}
+
+dao::LaserPoint PointBuffer::point(qsizetype i) const
+{
+    return { .x = x(i), .y = y(i), .r = r_[i], .g = g_[i], .b = b_[i] };
+}
+
+void PointBuffer::append(const dao::LaserPoint & point)
+{
+    x_ << toFixed(point.x);
+    y_ << toFixed(point.y);
+    r_ << point.r;
+    g_ << point.g;
+    b_ << point.b;
+}
+
+void PointBuffer::append(const PointView & points)
+{
+    const qsizetype n = points.size();
+    if (n == 0) return;
+    appendRange(x_, points.xData(), n);
+    appendRange(y_, points.yData(), n);
+    appendRange(r_, points.rData(), n);
+    appendRange(g_, points.gData(), n);
+    appendRange(b_, points.bData(), n);
+}
+
+PointBuffer PointBuffer::mid(qsizetype pos, qsizetype count) const
+{
+    PointBuffer rv;
+    rv.append(view(pos, count));
+    return rv;
+}
+
+PointView PointBuffer::view(qsizetype pos, qsizetype count) const
+{
+    PointView rv;
+    rv.x_    = x_.constData();
+    rv.y_    = y_.constData();
+    rv.r_    = r_.constData();
+    rv.g_    = g_.constData();
+    rv.b_    = b_.constData();
+    rv.size_ = size();
+    return rv.mid(pos, count);
+}
+
+dao::LaserPoints PointBuffer::toLaserPoints() const
+{
+    dao::LaserPoints rv;
+    rv.reserve(size());
+    for (qsizetype i = 0 ; i < size() ; ++i) rv << point(i);
+    return rv;
+}
+
+PointView PointView::mid(qsizetype pos, qsizetype count) const
+{
+    pos = qBound<qsizetype>(0, pos, size_);
+    if (count < 0 || count > size_ - pos) count = size_ - pos;
+    PointView rv = *this;
+    rv.x_   += pos;
+    rv.y_   += pos;
+    rv.r_   += pos;
+    rv.g_   += pos;
+    rv.b_   += pos;
+    rv.size_ = count;
+    return rv;
+}
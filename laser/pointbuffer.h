@@ -0,0 +1,103 @@
+#pragma once
+
+#include <dao/laserpoint.h>
+
+class PointView;
+
+// Compact point storage: fixed point coordinates and colors in separate arrays (7 bytes per point).
+// Coordinates are stored with a resolution of 1/16384 in the range -2.0 ... 2.0,
+// which is 8 times finer than the device and leaves room for clipping.
+// Coordinates outside are clamped, before output correction is applied.
+// dao::LaserPoint is only used on the wire.
+class PointBuffer
+{
+public:
+    static constexpr double Scale = 16384.0;
+
+    static qint16 toFixed(double v) { return (qint16)qBound(-32768.0, std::round(v * Scale), 32767.0); }
+    static double toDouble(qint16 v) { return v / Scale; }
+
+public:
+    PointBuffer() = default;
+    PointBuffer(const dao::LaserPoints & points);
+    PointBuffer(qsizetype count, const dao::LaserPoint & point);
+
+    qsizetype size() const { return x_.size(); }
+    bool isEmpty() const { return x_.isEmpty(); }
+    void clear();
+    void reserve(qsizetype count);
+    // new points are 0.0 / 0.0 / black
+    void resize(qsizetype count);
+
+    double x(qsizetype i) const { return toDouble(x_[i]); }
+    double y(qsizetype i) const { return toDouble(y_[i]); }
+    quint8 r(qsizetype i) const { return r_[i]; }
+    quint8 g(qsizetype i) const { return g_[i]; }
+    quint8 b(qsizetype i) const { return b_[i]; }
+    dao::LaserPoint point(qsizetype i) const;
+
+    const qint16 * xData() const { return x_.constData(); }
+    const qint16 * yData() const { return y_.constData(); }
+    const quint8 * rData() const { return r_.constData(); }
+    const quint8 * gData() const { return g_.constData(); }
+    const quint8 * bData() const { return b_.constData(); }
+
+    // for in-place updates
+    qint16 * xData() { return x_.data(); }
+    qint16 * yData() { return y_.data(); }
+    quint8 * rData() { return r_.data(); }
+    quint8 * gData() { return g_.data(); }
+    quint8 * bData() { return b_.data(); }
+
+    void append(const dao::LaserPoint & point);
+    void append(const PointView & points);  // points must not be a view of this buffer
+    PointBuffer & operator<<(const dao::LaserPoint & point) { append(point); return *this; }
+    PointBuffer & operator<<(const PointView & points) { append(points); return *this; }
+
+    PointBuffer mid(qsizetype pos, qsizetype count = -1) const;
+    PointView view(qsizetype pos = 0, qsizetype count = -1) const;
+    dao::LaserPoints toLaserPoints() const;
+
+private:
+    QVector<qint16> x_;
+    QVector<qint16> y_;
+    QVector<quint8> r_;
+    QVector<quint8> g_;
+    QVector<quint8> b_;
+};
+
+// Non-owning slice of a PointBuffer.
+// It is valid as long as the buffer is neither modified nor destroyed.
+class PointView
+{
+public:
+    PointView() = default;
+    PointView(const PointBuffer & buffer) : PointView(buffer.view()) {}
+
+    qsizetype size() const { return size_; }
+    bool isEmpty() const { return size_ == 0; }
+
+    double x(qsizetype i) const { return PointBuffer::toDouble(x_[i]); }
+    double y(qsizetype i) const { return PointBuffer::toDouble(y_[i]); }
+    quint8 r(qsizetype i) const { return r_[i]; }
+    quint8 g(qsizetype i) const { return g_[i]; }
+    quint8 b(qsizetype i) const { return b_[i]; }
+    dao::LaserPoint point(qsizetype i) const { return { .x = x(i), .y = y(i), .r = r_[i], .g = g_[i], .b = b_[i] }; }
+
+    const qint16 * xData() const { return x_; }
+    const qint16 * yData() const { return y_; }
+    const quint8 * rData() const { return r_; }
+    const quint8 * gData() const { return g_; }
+    const quint8 * bData() const { return b_; }
+
+    PointView mid(qsizetype pos, qsizetype count = -1) const;
+
+private:
+    friend class PointBuffer;
+    const qint16 * x_ = nullptr;
+    const qint16 * y_ = nullptr;
+    const quint8 * r_ = nullptr;
+    const quint8 * g_ = nullptr;
+    const quint8 * b_ = nullptr;
+    qsizetype      size_ = 0;
+};
@@ -0,0 +1,141 @@
+#include "previewsink.h"
+
+#include <laser/laser.h>
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Etc)
+
+namespace {
+
+constexpr qint64 RepeatInterval = 1000000;  // us between repeated previews
+
+inline bool isLit(const EasyLase::Point & p) { return p.r || p.g || p.b; }
+
+inline dao::LaserPoint toPreview(const EasyLase::Point & p, bool isLit)
+{
+    dao::LaserPoint rv;
+    rv.x = p.x / 2047.5 - 1.0;
+    rv.y = p.y / 2047.5 - 1.0;
+    if (isLit) {
+        rv.r = p.r;
+        rv.g = p.g;
+        rv.b = p.b;
+    }
+    return rv;
+}
+
+struct Run
+{
+    qsizetype begin;
+    qsizetype end;  // exclusive
+};
+
+}
+
+PreviewSink::PreviewSink(PreviewFunc callback)
+:
+    ThreadVerify("Preview", Worker),
+    callback_(callback),
+    publishTimer_(this, &PreviewSink::publish)
+{
+}
+
+PreviewSink::~PreviewSink()
+{
+    stopVerifyThread();
+}
+
+void PreviewSink::setConfig(const Config & config)
+{
+    if (!verifyThreadCall(&PreviewSink::setConfig, config)) return;
+    logFunctionTrace
+    config_ = config;
+    config_.maxRate = qMax(0.1, config_.maxRate);
+    isNew_ = true;
+    publish();
+}
+
+void PreviewSink::frame(const FramePtr & frame)
+{
+    if (!verifyThreadCall(&PreviewSink::frame, frame)) return;
+    latest_ = frame;
+    isNew_  = true;
+    publish();
+}
+
+void PreviewSink::publish()
+{
+    if (config_.pointBudget <= 0 || !latest_) return;
+
+    // new frames are rate limited, otherwise the last preview is repeated
+    const qint64 time = Laser::now();
+    const qint64 due  = lastPublish_ + (isNew_ ? qint64(1e6 / config_.maxRate) : RepeatInterval);
+    if (time < due) {
+        publishTimer_.singleShot((due - time) / 1e6);
+        return;
+    }
+    if (isNew_) {
+        preview_ = decimate(latest_->points, config_.pointBudget);
+        isNew_   = false;
+    }
+    lastPublish_ = time;
+    logTrace("publishing preview of frame %1 with %2 points", latest_->seq, preview_.size());
+    callback_(preview_);
+    publishTimer_.singleShot(RepeatInterval / 1e6);
+}
+
+dao::LaserPoints PreviewSink::decimate(const EasyLase::Points & points, int pointBudget)
+{
+    // lit runs without dwell and replicated points, blanked points only mark moves
+    QList<EasyLase::Point> lit;
+    QList<Run>             runs;
+    bool wasLit = false;
+    for (const EasyLase::Point & p : points) {
+        if (!isLit(p)) {
+            wasLit = false;
+            continue;
+        }
+        if (!wasLit) {
+            runs << Run{ .begin = lit.size(), .end = lit.size() };
+        } else {
+            const EasyLase::Point & last = lit.last();
+            if (p.x == last.x && p.y == last.y && p.r == last.r && p.g == last.g && p.b == last.b) continue;
+        }
+        lit << p;
+        runs.last().end = lit.size();
+        wasLit = true;
+    }
+
+    // every run costs a move, its start and its end
+    qsizetype fixed    = 0;
+    qsizetype interior = 0;
+    for (const Run & run : runs) {
+        const qsizetype size = run.end - run.begin;
+        fixed    += 1 + qMin<qsizetype>(size, 2);
+        interior += qMax<qsizetype>(0, size - 2);
+    }
+    const double runRate      = fixed > pointBudget ? (double)pointBudget / fixed : 1.0;
+    const double interiorRate = interior > 0 ? qBound(0.0, (double)(pointBudget - fixed) / interior, 1.0) : 0.0;
+
+    dao::LaserPoints rv;
+    rv.reserve(qMin<qsizetype>(pointBudget, fixed + interior) + 3);
+    double runAcc      = 0.0;
+    double interiorAcc = 0.0;
+    for (const Run & run : runs) {
+        runAcc += runRate;
+        if (runAcc < 1.0) continue;
+        runAcc -= 1.0;
+
+        rv << toPreview(lit[run.begin], false);
+        rv << toPreview(lit[run.begin], true);
+        for (qsizetype i = run.begin + 1 ; i < run.end - 1 ; ++i) {
+            interiorAcc += interiorRate;
+            if (interiorAcc < 1.0) continue;
+            interiorAcc -= 1.0;
+            rv << toPreview(lit[i], true);
+        }
+        if (run.end - run.begin > 1) rv << toPreview(lit[run.end - 1], true);
+    }
+    return rv;
+}
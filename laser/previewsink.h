@@ -0,0 +1,48 @@
+#pragma once
+
+#include <dao/laserpoint.h>
+#include <laser/framesink.h>
+
+#include <cflib/util/evtimer.h>
+#include <cflib/util/threadverify.h>
+
+// Publishes a decimated copy of the output frames for live previews.
+// Previews are rate limited and the last one is repeated now and then for late subscribers,
+// so the cost does not depend on how fast frames change.
+class PreviewSink : public FrameSink, private cflib::util::ThreadVerify
+{
+public:
+    // Points in wire format, colored points are drawn from the previous point,
+    // black points are blanked moves. No points means output is off.
+    using PreviewFunc = std::function<void (const dao::LaserPoints & points)>;
+
+    struct Config
+    {
+        int    pointBudget = 256;   // per preview, 0 -> disabled
+        double maxRate     = 10.0;  // previews per second
+    };
+
+public:
+    PreviewSink(PreviewFunc callback);
+    ~PreviewSink();
+
+    void setConfig(const Config & config);
+
+    void frame(const FramePtr & frame) override;
+
+    // Keeps start and end of every lit run, interior points are thinned out evenly.
+    // If the runs alone exceed the budget, whole runs are dropped evenly.
+    static dao::LaserPoints decimate(const EasyLase::Points & points, int pointBudget);
+
+private:
+    void publish();
+
+private:
+    PreviewFunc          callback_;
+    Config               config_;
+    FramePtr             latest_;
+    bool                 isNew_ = false;
+    dao::LaserPoints     preview_;
+    qint64               lastPublish_ = 0;  // us
+    cflib::util::EVTimer publishTimer_;
+};
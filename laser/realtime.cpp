@@ -0,0 +1,166 @@
+#include "realtime.h"
+
+#include <cflib/util/log.h>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+USE_LOG(LogCat::Etc)
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+namespace realtime {
+
+namespace {
+
+// not wrapped by glibc
+struct SchedAttr
+{
+    quint32 size;
+    quint32 policy;
+    quint64 flags;
+    qint32  nice;
+    quint32 priority;
+    quint64 runtime;
+    quint64 deadline;
+    quint64 period;
+};
+
+bool setDeadline(quint64 runtime, quint64 period)
+{
+    SchedAttr attr{
+        .size     = sizeof(SchedAttr),
+        .policy   = SCHED_DEADLINE,
+        .flags    = 0,
+        .nice     = 0,
+        .priority = 0,
+        .runtime  = runtime,
+        .deadline = period,
+        .period   = period
+    };
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) == 0) return true;
+    logWarn("cannot set SCHED_DEADLINE (runtime: %1us, period: %2us): %3",
+        runtime / 1000, period / 1000, strerror(errno));
+    return false;
+}
+
+bool setFifo(int priority)
+{
+    sched_param param{};
+    param.sched_priority = qBound(sched_get_priority_min(SCHED_FIFO), priority, sched_get_priority_max(SCHED_FIFO));
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) return true;
+    logWarn("cannot set SCHED_FIFO with priority %1 (missing CAP_SYS_NICE?)", param.sched_priority);
+    return false;
+}
+
+bool pin(const QList<int> & cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err == 0) return true;
+    logWarn("cannot pin thread to cpus %1: %2", cpus.size(), strerror(err));
+    return false;
+}
+
+void prefaultStack(int size)
+{
+    volatile char * stack = static_cast<char *>(alloca(size));
+    for (int i = 0 ; i < size ; i += 4096) stack[i] = 0;
+}
+
+}
+
+bool parsePolicy(const QByteArray & str, Config & config)
+{
+    const QList<QByteArray> parts = str.split(':');
+    bool ok = parts.size() <= 2;
+    if (parts[0] == "normal" && parts.size() == 1) {
+        config.policy = Policy::Normal;
+    } else if (parts[0] == "fifo") {
+        config.policy = Policy::Fifo;
+        if (parts.size() == 2) config.priority = parts[1].toInt(&ok);
+    } else if (parts[0] == "deadline") {
+        config.policy = Policy::Deadline;
+        if (parts.size() == 2) {
+            const QList<QByteArray> times = parts[1].split('/');
+            bool ok2 = times.size() == 2;
+            if (ok2) config.runtime = times[0].toULongLong(&ok)  * 1000;
+            if (ok2) config.period  = times[1].toULongLong(&ok2) * 1000;
+            ok = ok && ok2 && config.runtime > 0 && config.runtime <= config.period;
+        }
+    } else {
+        ok = false;
+    }
+    return ok;
+}
+
+bool parseCpus(const QByteArray & str, Config & config)
+{
+    config.cpus.clear();
+    for (const QByteArray & part : str.split(',')) {
+        const QList<QByteArray> range = part.split('-');
+        if (range.size() > 2) return false;
+        bool ok1 = true;
+        bool ok2 = true;
+        const int first = range[0].toInt(&ok1);
+        const int last  = range.size() == 2 ? range[1].toInt(&ok2) : first;
+        if (!ok1 || !ok2 || first < 0 || last < first || last >= CPU_SETSIZE) return false;
+        for (int cpu = first ; cpu <= last ; ++cpu) config.cpus << cpu;
+    }
+    return true;
+}
+
+bool applyToCurrentThread(const Config & config)
+{
+    bool rv = true;
+
+    // SCHED_DEADLINE needs all cpus of its root domain, so pinning comes first and may make it fail
+    if (!config.cpus.isEmpty()) rv = pin(config.cpus);
+
+    switch (config.policy) {
+        case Policy::Normal:
+            break;
+        case Policy::Deadline:
+            if (setDeadline(config.runtime, config.period)) break;
+            rv = false;
+            [[fallthrough]];
+        case Policy::Fifo:
+            if (!setFifo(config.priority)) rv = false;
+            break;
+    }
+
+    if (config.prefaultStack > 0) prefaultStack(config.prefaultStack);
+    logInfo("real-time config applied %1", rv ? "completely" : "with fallback");
+    return rv;
+}
+
+bool lockMemory(qsizetype prefaultHeap)
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        logWarn("cannot lock memory (missing CAP_IPC_LOCK or RLIMIT_MEMLOCK too low?): %1", strerror(errno));
+        return false;
+    }
+
+    // keep freed memory in the heap and never use separate mappings
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (prefaultHeap > 0) {
+        volatile char * heap = static_cast<char *>(malloc(prefaultHeap));
+        if (heap) {
+            for (qsizetype i = 0 ; i < prefaultHeap ; i += 4096) heap[i] = 0;
+            free(const_cast<char *>(heap));
+        }
+    }
+    logInfo("memory locked, %1 bytes of heap prefaulted", prefaultHeap);
+    return true;
+}
+
+}
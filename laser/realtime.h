@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QtCore>
+
+// Real-time scheduling for time-critical threads (Linux only).
+// Every step falls back gracefully with a warning, if privileges are missing.
+namespace realtime {
+
+enum class Policy { Normal, Fifo, Deadline };
+
+struct Config
+{
+    Policy     policy        = Policy::Normal;
+    int        priority      = 80;          // SCHED_FIFO: 1 ... 99
+    quint64    runtime       = 500000;      // SCHED_DEADLINE: ns of cpu time per period
+    quint64    period        = 2000000;     // SCHED_DEADLINE: ns, also used as deadline
+    QList<int> cpus;                        // pin to these cpus, empty -> no pinning
+    int        prefaultStack = 256 * 1024;  // bytes of stack touched in advance
+};
+
+// Parses "normal", "fifo[:priority]" or "deadline[:runtime_us/period_us]".
+bool parsePolicy(const QByteArray & str, Config & config);
+
+// Parses a list like "2,3" or "2-5".
+bool parseCpus(const QByteArray & str, Config & config);
+
+// Applies config to the calling thread.
+// Returns false, if it fell back to something less (SCHED_DEADLINE -> SCHED_FIFO -> normal).
+bool applyToCurrentThread(const Config & config);
+
+// Locks current and future memory of the process and prefaults heap.
+// Freed memory is kept in the heap, so later allocations do not page fault.
+bool lockMemory(qsizetype prefaultHeap);
+
+}
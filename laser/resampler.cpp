@@ -0,0 +1,151 @@
+#include "resampler.h"
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+using dao::LaserPoint;
+using dao::LaserPoints;
+
+namespace {
+
+inline bool sameColor(const LaserPoint & a, const LaserPoint & b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+inline bool isSame(const LaserPoint & a, const LaserPoint & b) { return a.x == b.x && a.y == b.y && sameColor(a, b); }
+
+// Plain loops over separate arrays, so the compiler can vectorize them.
+void edgeLengths(const float * x, const float * y, float * len, int edges)
+{
+    for (int i = 0 ; i < edges ; ++i) {
+        const float dx = x[i + 1] - x[i];
+        const float dy = y[i + 1] - y[i];
+        len[i] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+// Nearest neighbours at another position, -1 / count if there is none.
+void distinctNeighbours(const float * x, const float * y, int * prev, int * next, int count)
+{
+    for (int i = 0 ; i < count ; ++i) {
+        prev[i] = i > 0 && x[i - 1] == x[i] && y[i - 1] == y[i] ? prev[i - 1] : i - 1;
+    }
+    for (int i = count - 1 ; i >= 0 ; --i) {
+        next[i] = i < count - 1 && x[i + 1] == x[i] && y[i + 1] == y[i] ? next[i + 1] : i + 1;
+    }
+}
+
+// Turn between the distinct neighbours, so that repeated points do not hide a corner.
+void turnCosines(const float * x, const float * y, const int * prev, const int * next, float * cosine, int count)
+{
+    for (int i = 0 ; i < count ; ++i) {
+        const int p = prev[i];
+        const int q = next[i];
+        if (p < 0 || q >= count) continue;
+        const float ax = x[i] - x[p], ay = y[i] - y[p];
+        const float bx = x[q] - x[i], by = y[q] - y[i];
+        cosine[i] = (ax * bx + ay * by) / std::sqrt((ax * ax + ay * ay) * (bx * bx + by * by));
+    }
+}
+}
+
+LaserPoints Resampler::resample(const LaserPoints & points) const
+{
+    const int n = points.size();
+    if (!isEnabled() || n < 2) return points;
+
+    QVector<float> xs(n), ys(n);
+    for (int i = 0 ; i < n ; ++i) {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
+    QVector<float> len(n - 1);
+    edgeLengths(xs.constData(), ys.constData(), len.data(), n - 1);
+    QVector<int> prev(n), next(n);
+    distinctNeighbours(xs.constData(), ys.constData(), prev.data(), next.data(), n);
+    QVector<float> cosine(n, 1.0f);
+    turnCosines(xs.constData(), ys.constData(), prev.constData(), next.constData(), cosine.data(), n);
+
+    // key points: ends, color changes, corners and dwell, a run of repeated points turns at its first one
+    const double cornerLimit = config_.cornerAngle * std::numbers::pi / 180.0;
+    QVector<float> turn(n, 0.0f);
+    QVector<int>   keys;
+    QVector<int>   dwell;
+    int fixedCount = 0;
+    for (int i = 0 ; i < n ; ) {
+        int run = 1;
+        while (i + run < n && isSame(points[i + run], points[i])) ++run;
+        const int    last     = i + run - 1;
+        const double angle    = std::acos(qBound(-1.0, (double)cosine[i], 1.0));
+        const bool   isCorner = angle >= cornerLimit;
+        turn[i] = angle;
+        const bool isKey = i == 0 || last == n - 1 || run > 1 || isCorner ||
+            !sameColor(points[i], points[i - 1]) || !sameColor(points[last], points[last + 1]);
+        if (isKey) {
+            keys  << i;
+            dwell << qMax(run - 1, isCorner ? qRound(config_.cornerDwell * angle / std::numbers::pi) : 0);
+            fixedCount += 1 + dwell.last();
+        }
+        i += run;
+    }
+
+    if (keys.size() > config_.pointBudget) {
+        logDebug("cannot resample %1 points with %2 key points to budget of %3",
+            n, keys.size(), config_.pointBudget);
+        return points;
+    }
+    if (fixedCount > config_.pointBudget) {
+        const double scale = (double)(config_.pointBudget - keys.size()) / (fixedCount - keys.size());
+        fixedCount = keys.size();
+        for (int & d : dwell) fixedCount += (d = d * scale);
+    }
+
+    // weight of every edge: arc length plus curvature of its inner ends
+    QVector<double> weight(n - 1);
+    for (int i = 0 ; i < n - 1 ; ++i) weight[i] = len[i] + config_.curvatureWeight * (turn[i] + turn[i + 1]) / 2;
+    for (int k : keys) {
+        if (k > 0)     weight[k - 1] -= config_.curvatureWeight * turn[k] / 2;
+        if (k < n - 1) weight[k]     -= config_.curvatureWeight * turn[k] / 2;
+    }
+    double totalWeight = 0.0;
+    for (double w : weight) totalWeight += w;
+    if (totalWeight <= 0.0) return points;
+
+    const int free = config_.pointBudget - fixedCount;
+    LaserPoints rv;
+    rv.reserve(config_.pointBudget);
+    double cumWeight = 0.0;
+    for (int ki = 0 ; ki < keys.size() ; ++ki) {
+        const LaserPoint & key = points[keys[ki]];
+        for (int i = 0 ; i <= dwell[ki] ; ++i) rv << key;
+        if (ki + 1 == keys.size()) break;
+
+        // samples of this run, uniformly spaced in weight
+        const int begin = keys[ki];
+        const int end   = keys[ki + 1];
+        double runWeight = 0.0;
+        for (int e = begin ; e < end ; ++e) runWeight += weight[e];
+        const int samples = qRound((cumWeight + runWeight) * free / totalWeight) - qRound(cumWeight * free / totalWeight);
+        cumWeight += runWeight;
+        if (samples <= 0 || runWeight <= 0.0) continue;
+
+        const double step = runWeight / (samples + 1);
+        int    e       = begin;
+        double edgeEnd = weight[e];
+        double pos     = step;
+        for (int s = 0 ; s < samples ; ++s, pos += step) {
+            while (pos > edgeEnd && e + 1 < end) edgeEnd += weight[++e];
+            const double t = weight[e] > 0.0 ? 1.0 - (edgeEnd - pos) / weight[e] : 0.0;
+            const LaserPoint & a = points[e];
+            const LaserPoint & b = points[e + 1];
+            rv << LaserPoint{
+                .x = a.x + (b.x - a.x) * t,
+                .y = a.y + (b.y - a.y) * t,
+                .r = a.r,
+                .g = a.g,
+                .b = a.b
+            };
+        }
+    }
+
+    logTrace("resampled %1 points (%2 keys) to %3", n, keys.size(), rv.size());
+    return rv;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <dao/laserpoint.h>
+
+// Re-parameterizes a path by arc length and curvature to a fixed point budget.
+// Corners and color changes are kept exactly, straight runs get thinned out.
+// Repeated points are dwell of the client, they are kept as well (within the budget).
+class Resampler
+{
+public:
+    struct Config
+    {
+        int    pointBudget     = 0;     // points per frame, 0 -> disabled
+        double cornerAngle     = 20.0;  // turns above this angle (degrees) are kept as corners
+        double cornerDwell     = 4.0;   // extra samples for a 180 degree corner
+        double curvatureWeight = 0.02;  // arc length equivalent of one radian turn
+    };
+
+public:
+    Resampler() = default;
+    Resampler(const Config & config) : config_(config) {}
+
+    const Config & config() const { return config_; }
+    bool isEnabled() const { return config_.pointBudget > 0; }
+
+    dao::LaserPoints resample(const dao::LaserPoints & points) const;
+
+private:
+    Config config_;
+};
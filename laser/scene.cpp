@@ -0,0 +1,86 @@
+#include "scene.h"
+
+#include <laser/blanking.h>
+#include <laser/laser.h>
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+namespace {
+
+dao::LaserPoints transformed(const dao::SceneObject & object)
+{
+    const double c = std::cos(object.rotation) * object.scale;
+    const double s = std::sin(object.rotation) * object.scale;
+    dao::LaserPoints rv;
+    rv.reserve(object.points.size());
+    for (const dao::LaserPoint & p : object.points) {
+        rv << dao::LaserPoint{
+            .x = object.x + c * p.x - s * p.y,
+            .y = object.y + s * p.x + c * p.y,
+            .r = quint8(p.r * object.r / 255),
+            .g = quint8(p.g * object.g / 255),
+            .b = quint8(p.b * object.b / 255)
+        };
+    }
+    return rv;
+}
+
+}
+
+Scene::Scene() :
+    pps_(Laser::MaxSpeed)
+{
+}
+
+void Scene::setSpeed(quint16 pps)
+{
+    if (pps == pps_) return;
+    pps_ = pps;
+    for (Entry & e : objects_) e.dirty = true;
+}
+
+void Scene::setObject(const QString & id, const dao::SceneObject & object)
+{
+    Entry & e = objects_[id];
+    e.object = object;
+    e.dirty  = true;
+}
+
+bool Scene::removeObject(const QString & id)
+{
+    return objects_.remove(id) > 0;
+}
+
+void Scene::clear()
+{
+    objects_.clear();
+}
+
+EasyLase::Points Scene::render()
+{
+    int converted = 0;
+    qsizetype total = 0;
+    for (Entry & e : objects_) {
+        if (e.dirty) {
+            e.points = e.object.visible ? Laser::convert(transformed(e.object), pps_) : EasyLase::Points();
+            e.dirty  = false;
+            ++converted;
+        }
+        total += e.points.size();
+    }
+
+    EasyLase::Points rv;
+    rv.reserve(total);
+    for (const Entry & e : objects_) {
+        if (e.points.isEmpty()) continue;
+        if (!rv.isEmpty()) appendBlankJump(rv, rv.last(), e.points.first());
+        rv += e.points;
+    }
+    // content gets repeated
+    if (!rv.isEmpty()) appendBlankJump(rv, rv.last(), rv.first());
+
+    logDebug("rendered scene with %1 objects (%2 converted) to %3 points", objects_.size(), converted, rv.size());
+    return rv;
+}
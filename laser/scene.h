@@ -0,0 +1,34 @@
+#pragma once
+
+#include <dao/sceneobject.h>
+#include <laser/easylase.h>
+
+// Retained-mode content: every object keeps its converted device points,
+// so an update only reconverts objects which have changed.
+// This class has no threading.
+class Scene
+{
+public:
+    Scene();
+
+    // All objects get reconverted on next render(). pps must not be 0.
+    void setSpeed(quint16 pps);
+
+    void setObject(const QString & id, const dao::SceneObject & object);
+    bool removeObject(const QString & id);
+    void clear();
+
+    // Converts dirty objects and stitches all visible ones (ordered by id) with blank jumps.
+    EasyLase::Points render();
+
+private:
+    struct Entry
+    {
+        dao::SceneObject object;
+        EasyLase::Points points;
+        bool             dirty = true;
+    };
+
+    quint16              pps_;
+    QMap<QString, Entry> objects_;
+};
@@ -0,0 +1,219 @@
+#include "shmring.h"
+
+#include <cflib/util/log.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+USE_LOG(LogCat::Etc)
+
+namespace {
+
+constexpr quint32 Magic      = 0x52534C43;  // "CLSR"
+constexpr quint32 Version    = 1;
+constexpr size_t  HeaderSize = 4096;
+constexpr size_t  SlotSize   = 65536;       // count + EasyLase::MaxPoints points
+constexpr size_t  PointsPos  = 8;
+
+static_assert(PointsPos + EasyLase::MaxPoints * sizeof(EasyLase::Point) <= SlotSize);
+static_assert(std::atomic<quint64>::is_always_lock_free, "shared atomics must be lock free");
+
+void closeFd(int fd)
+{
+    if (fd >= 0) ::close(fd);
+}
+
+}
+
+struct ShmRing::Header
+{
+    quint32                          magic;
+    quint32                          version;
+    quint32                          slotCount;
+    quint32                          slotSize;
+    alignas(64) std::atomic<quint64> writePos;
+    alignas(64) std::atomic<quint64> readPos;
+    alignas(64) std::atomic<quint32> isProducerWaiting;
+};
+
+ShmRing::ShmRing(int memFd, int dataFd, int spaceFd, int socketFd) :
+    memFd_(memFd),
+    dataFd_(dataFd),
+    spaceFd_(spaceFd),
+    socketFd_(socketFd)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    if (mem_) munmap(mem_, size_);
+    closeFd(memFd_);
+    closeFd(dataFd_);
+    closeFd(spaceFd_);
+    closeFd(socketFd_);
+}
+
+std::unique_ptr<ShmRing> ShmRing::create(int slotCount)
+{
+    const int memFd = memfd_create("cflase-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    std::unique_ptr<ShmRing> ring(new ShmRing(memFd,
+        eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK), eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK), -1));
+    if (memFd < 0 || ring->dataFd_ < 0 || ring->spaceFd_ < 0) {
+        logWarn("cannot create shared memory ring: %1", strerror(errno));
+        return nullptr;
+    }
+
+    // clients must not be able to resize it under our feet
+    const size_t size = HeaderSize + slotCount * SlotSize;
+    if (ftruncate(memFd, size) != 0 || fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        logWarn("cannot size shared memory ring: %1", strerror(errno));
+        return nullptr;
+    }
+    ring->size_ = size;
+    ring->mem_  = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+    if (ring->mem_ == MAP_FAILED) {
+        ring->mem_ = nullptr;
+        logWarn("cannot map shared memory ring: %1", strerror(errno));
+        return nullptr;
+    }
+
+    static_assert(sizeof(Header) <= HeaderSize);
+    ring->header_ = new (ring->mem_) Header{
+        .magic             = Magic,
+        .version           = Version,
+        .slotCount         = (quint32)slotCount,
+        .slotSize          = SlotSize,
+        .writePos          = 0,
+        .readPos           = 0,
+        .isProducerWaiting = 0
+    };
+    ring->slots_ = slotCount;
+    return ring;
+}
+
+std::unique_ptr<ShmRing> ShmRing::connect(const QByteArray & socketPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= (int)sizeof(addr.sun_path)) return nullptr;
+    memcpy(addr.sun_path, socketPath.constData(), socketPath.size());
+
+    const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+        logWarn("cannot connect to %1: %2", socketPath, strerror(errno));
+        closeFd(fd);
+        return nullptr;
+    }
+
+    // memory and both eventfds come as ancillary data
+    int fds[3] = { -1, -1, -1 };
+    char byte;
+    iovec iov{ .iov_base = &byte, .iov_len = 1 };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    msghdr msg{};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    const cmsghdr * cmsg = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC) > 0 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        logWarn("no shared memory ring received from %1", socketPath);
+        closeFd(fd);
+        return nullptr;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+    std::unique_ptr<ShmRing> ring = attach(fds[0], fds[1], fds[2]);
+    if (ring) ring->socketFd_ = fd;
+    else      closeFd(fd);
+    return ring;
+}
+
+std::unique_ptr<ShmRing> ShmRing::attach(int memFd, int dataFd, int spaceFd)
+{
+    std::unique_ptr<ShmRing> ring(new ShmRing(memFd, dataFd, spaceFd, -1));
+    if (!ring->map()) {
+        logWarn("invalid shared memory ring");
+        return nullptr;
+    }
+    return ring;
+}
+
+bool ShmRing::map()
+{
+    struct stat st;
+    if (fstat(memFd_, &st) != 0 || (size_t)st.st_size <= HeaderSize) return false;
+    size_ = st.st_size;
+    mem_  = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, memFd_, 0);
+    if (mem_ == MAP_FAILED) {
+        mem_ = nullptr;
+        return false;
+    }
+    header_ = static_cast<Header *>(mem_);
+    slots_  = header_->slotCount;
+    return header_->magic == Magic && header_->version == Version && header_->slotSize == SlotSize &&
+        slots_ > 0 && size_ == HeaderSize + slots_ * SlotSize;
+}
+
+EasyLase::Point * ShmRing::slot(quint64 pos) const
+{
+    return reinterpret_cast<EasyLase::Point *>(
+        static_cast<char *>(mem_) + HeaderSize + (pos % slots_) * SlotSize + PointsPos);
+}
+
+EasyLase::Point * ShmRing::beginWrite(int timeout)
+{
+    for (;;) {
+        const quint64 pos = header_->writePos.load(std::memory_order_relaxed);
+        if (pos - header_->readPos.load(std::memory_order_acquire) < (quint64)slots_) return slot(pos);
+        if (timeout == 0) return nullptr;
+
+        // the consumer may have released a slot right before the flag was set
+        header_->isProducerWaiting.store(1);
+        if (pos - header_->readPos.load() < (quint64)slots_) continue;
+
+        pollfd pfd{ .fd = spaceFd_, .events = POLLIN, .revents = 0 };
+        if (poll(&pfd, 1, timeout) <= 0) return nullptr;
+        eventfd_t value;
+        eventfd_read(spaceFd_, &value);
+    }
+}
+
+void ShmRing::commit(int count)
+{
+    const quint64 pos = header_->writePos.load(std::memory_order_relaxed);
+    quint32 * size = reinterpret_cast<quint32 *>(reinterpret_cast<char *>(slot(pos)) - PointsPos);
+    *size = qBound<int>(0, count, EasyLase::MaxPoints);
+    header_->writePos.store(pos + 1, std::memory_order_release);
+    eventfd_write(dataFd_, 1);
+}
+
+const EasyLase::Point * ShmRing::peek(int & count) const
+{
+    const quint64 pos = header_->readPos.load(std::memory_order_relaxed);
+    if (pos == header_->writePos.load(std::memory_order_acquire)) return nullptr;
+
+    // the producer is not trusted
+    const EasyLase::Point * points = slot(pos);
+    const quint32 size = *reinterpret_cast<const quint32 *>(reinterpret_cast<const char *>(points) - PointsPos);
+    count = qMin<quint32>(size, EasyLase::MaxPoints);
+    return points;
+}
+
+void ShmRing::release()
+{
+    header_->readPos.fetch_add(1, std::memory_order_release);
+    if (header_->isProducerWaiting.exchange(0)) eventfd_write(spaceFd_, 1);
+}
+
+qsizetype ShmRing::fill() const
+{
+    const quint64 fill = header_->writePos.load(std::memory_order_acquire) - header_->readPos.load(std::memory_order_relaxed);
+    return qMin<quint64>(fill, slots_);
+}
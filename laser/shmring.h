@@ -0,0 +1,72 @@
+#pragma once
+
+#include <laser/easylase.h>
+
+#include <atomic>
+
+// Single-producer / single-consumer ring of device frames in shared memory (memfd).
+// Each slot holds one frame of up to EasyLase::MaxPoints points at EasyLase::MaxSpeed.
+// eventfds wake the consumer on new frames and a waiting producer on free slots.
+// A full ring is the backpressure for the producer.
+//
+// Local clients get the ring with connect(...) from ShmServer:
+//
+//     auto ring = ShmRing::connect("/tmp/cflase.sock");
+//     while (...) {
+//         EasyLase::Point * points = ring->beginWrite(100);
+//         if (!points) continue;
+//         ... write up to EasyLase::MaxPoints points ...
+//         ring->commit(count);
+//     }
+//
+// This class has no threading, each side must be used by one thread only.
+class ShmRing
+{
+public:
+    static constexpr int DefaultSlots = 8;
+
+    ~ShmRing();
+
+    // consumer side: creates memory and eventfds
+    static std::unique_ptr<ShmRing> create(int slotCount = DefaultSlots);
+    // producer side: maps the ring of a server, the connection stays open for its lifetime
+    static std::unique_ptr<ShmRing> connect(const QByteArray & socketPath);
+    // producer side: maps a ring of passed file descriptors (takes ownership)
+    static std::unique_ptr<ShmRing> attach(int memFd, int dataFd, int spaceFd);
+
+    int slotCount() const { return slots_; }
+    int memFd()   const { return memFd_; }
+    int dataFd()  const { return dataFd_; }   // readable after commits
+    int spaceFd() const { return spaceFd_; }  // readable after a waiting producer got space
+
+    // producer: free slot or nullptr after timeout (ms, < 0 -> infinite, 0 -> no waiting)
+    EasyLase::Point * beginWrite(int timeout);
+    void commit(int count);
+
+    // consumer: oldest frame or nullptr
+    const EasyLase::Point * peek(int & count) const;
+    void release();
+    qsizetype fill() const;
+
+    // consumer: producer is gone, remaining frames are still shown
+    void close() { isClosed_ = true; }
+    bool isClosed() const { return isClosed_; }
+
+private:
+    struct Header;
+
+    ShmRing(int memFd, int dataFd, int spaceFd, int socketFd);
+    bool map();
+    EasyLase::Point * slot(quint64 pos) const;
+
+private:
+    int               memFd_;
+    int               dataFd_;
+    int               spaceFd_;
+    int               socketFd_;
+    int               slots_ = 0;
+    void *            mem_ = nullptr;
+    size_t            size_ = 0;
+    Header *          header_ = nullptr;
+    std::atomic<bool> isClosed_ = false;
+};
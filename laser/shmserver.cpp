@@ -0,0 +1,142 @@
+#include "shmserver.h"
+
+#include <laser/laser.h>
+
+#include <cflib/util/log.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+USE_LOG(LogCat::Etc)
+
+namespace {
+
+constexpr int PollTimeout = 10;  // ms, other calls wait at most that long
+
+}
+
+ShmServer::ShmServer(Laser & laser)
+:
+    ThreadVerify("ShmServer", Worker),
+    laser_(laser),
+    serveTimer_(this, &ShmServer::serve)
+{
+}
+
+ShmServer::~ShmServer()
+{
+    stopVerifyThread();
+    if (ring_) ring_->close();
+    if (clientFd_ >= 0) ::close(clientFd_);
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        unlink(path_.constData());
+    }
+}
+
+bool ShmServer::start(const QByteArray & socketPath, int slotCount)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&ShmServer::start, socketPath, slotCount)) return stc.retval();
+    logFunctionTrace
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (listenFd_ >= 0 || socketPath.isEmpty() || socketPath.size() >= (int)sizeof(addr.sun_path)) return false;
+    memcpy(addr.sun_path, socketPath.constData(), socketPath.size());
+
+    // a stale socket of a previous run
+    unlink(socketPath.constData());
+    listenFd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listenFd_ < 0 || bind(listenFd_, (const sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd_, 4) != 0) {
+        logWarn("cannot listen on %1: %2", socketPath, strerror(errno));
+        if (listenFd_ >= 0) ::close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    path_  = socketPath;
+    slots_ = slotCount;
+    logInfo("shared memory rings with %1 slots on %2", slotCount, socketPath);
+    serveTimer_.singleShot(0);
+    return true;
+}
+
+void ShmServer::serve()
+{
+    pollfd fds[3] = {
+        { .fd = listenFd_,                        .events = POLLIN, .revents = 0 },
+        { .fd = clientFd_,                        .events = POLLIN, .revents = 0 },
+        { .fd = ring_ ? ring_->dataFd() : -1,     .events = POLLIN, .revents = 0 }
+    };
+    if (poll(fds, 3, PollTimeout) > 0) {
+        if (fds[2].revents & POLLIN) {
+            eventfd_t value;
+            eventfd_read(ring_->dataFd(), &value);
+            laser_.showRing(ring_);
+        }
+        if (fds[1].revents) {
+            char byte;
+            if (recv(clientFd_, &byte, 1, MSG_DONTWAIT) <= 0) closeClient();
+        }
+        if (fds[0].revents & POLLIN) accept();
+    }
+    serveTimer_.singleShot(0);
+}
+
+void ShmServer::accept()
+{
+    const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    if (clientFd_ >= 0) {
+        logWarn("rejecting shared memory client, another one is connected");
+        ::close(fd);
+        return;
+    }
+
+    std::shared_ptr<ShmRing> ring = ShmRing::create(slots_);
+    if (!ring) {
+        ::close(fd);
+        return;
+    }
+
+    // memory and eventfds go as ancillary data
+    const int fds[3] = { ring->memFd(), ring->dataFd(), ring->spaceFd() };
+    char byte = 0;
+    iovec iov{ .iov_base = &byte, .iov_len = 1 };
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))] = {};
+    msghdr msg{};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr * cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) != 1) {
+        logWarn("cannot pass shared memory ring: %1", strerror(errno));
+        ::close(fd);
+        return;
+    }
+
+    logInfo("shared memory client connected");
+    clientFd_ = fd;
+    ring_     = ring;
+}
+
+void ShmServer::closeClient()
+{
+    logInfo("shared memory client disconnected");
+
+    // frames still in the ring are shown
+    ring_->close();
+    laser_.showRing(ring_);
+    ring_.reset();
+    ::close(clientFd_);
+    clientFd_ = -1;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <laser/shmring.h>
+
+#include <cflib/util/evtimer.h>
+#include <cflib/util/threadverify.h>
+
+class Laser;
+
+// Hands out shared memory rings to local producers over a unix socket (see ShmRing::connect(...)).
+// One producer at a time, its frames are shown as soon as they are committed.
+// Disconnecting closes the ring.
+class ShmServer : private cflib::util::ThreadVerify
+{
+public:
+    static constexpr const char * DefaultPath = "/tmp/cflase.sock";
+
+public:
+    ShmServer(Laser & laser);
+    ~ShmServer();
+
+    bool start(const QByteArray & socketPath, int slotCount = ShmRing::DefaultSlots);
+
+private:
+    void serve();
+    void accept();
+    void closeClient();
+
+private:
+    Laser &                  laser_;
+    QByteArray               path_;
+    int                      slots_ = ShmRing::DefaultSlots;
+    int                      listenFd_ = -1;
+    int                      clientFd_ = -1;
+    std::shared_ptr<ShmRing> ring_;
+    cflib::util::EVTimer     serveTimer_;
+};
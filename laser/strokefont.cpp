@@ -0,0 +1,110 @@
+#include "strokefont.h"
+
+namespace {
+
+// Strokes are separated by space, every stroke is a list of digit pairs (x, y).
+// The baseline is at y = 2, so descenders can use y = 0 ... 1.
+const char * const Glyphs[] = {
+    "",                                   // ' '
+    "2824 22",                            // !
+    "1817 3837",                          // "
+    "1317 3337 0444 0646",                // #
+    "473818070615354443321203 2921",      // $
+    "0248 0818170708 3343423233",         // %
+    "4216172837360403122244",             // &
+    "2827",                               // '
+    "38272332",                           // (
+    "18272312",                           // )
+    "2327 0446 0644",                     // *
+    "2327 0545",                          // +
+    "2211",                               // ,
+    "1535",                               // -
+    "22",                                 // .
+    "0248",                               // /
+    "183847433212030718 1337",            // 0
+    "172822 1232",                        // 1
+    "07183847460242",                     // 2
+    "07183847463515 354443321203",        // 3
+    "32380444",                           // 4
+    "480805354443321203",                 // 5
+    "473818070312324344351504",           // 6
+    "084812",                             // 7
+    "15060718384746351504031232434435",   // 8
+    "463515060718384743321203",           // 9
+    "26 23",                              // :
+    "26 2312",                            // ;
+    "470543",                             // <
+    "0444 0646",                          // =
+    "074503",                             // >
+    "07183847462524 22",                  // ?
+    "3424152636344447381807031232",       // @
+    "022842 1535",                        // A
+    "02083847463505 3544433202",          // B
+    "4738180703123243",                   // C
+    "02083847433202",                     // D
+    "48080242 0535",                      // E
+    "480802 0535",                        // F
+    "47381807031232434525",               // G
+    "0208 4842 0545",                     // H
+    "1838 2822 1232",                     // I
+    "4843321203",                         // J
+    "0208 4804 1542",                     // K
+    "080242",                             // L
+    "0208254842",                         // M
+    "02084248",                           // N
+    "183847433212030718",                 // O
+    "02083847463505",                     // P
+    "183847433212030718 2442",            // Q
+    "02083847463505 2542",                // R
+    "473818070615354443321203",           // S
+    "0848 2822",                          // T
+    "080312324348",                       // U
+    "082248",                             // V
+    "0812253248",                         // W
+    "0842 0248",                          // X
+    "082548 2522",                        // Y
+    "08480242",                           // Z
+    "38282232",                           // [
+    "0842",                               // backslash
+    "18282212",                           // ]
+    "162836",                             // ^
+    "0141",                               // _
+    "1827",                               // `
+    "", "", "", "", "", "", "", "", "", "", "", "", "", "",  // a ... n (uppercase is used)
+    "", "", "", "", "", "", "", "", "", "", "", "",          // o ... z
+    "38272615242332",                     // {
+    "2921",                               // |
+    "18272635242312",                     // }
+    "05163445"                            // ~
+};
+static_assert(sizeof(Glyphs) / sizeof(Glyphs[0]) == 95);
+
+}
+
+dao::LaserPath StrokeFont::glyph(char c, double unit, quint8 r, quint8 g, quint8 b)
+{
+    if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+    if (c < ' ' || c > '~') c = '?';
+
+    dao::LaserPath rv;
+    bool isStrokeStart = true;
+    for (const char * p = Glyphs[c - ' '] ; *p ; ) {
+        if (*p == ' ') {
+            isStrokeStart = true;
+            ++p;
+            continue;
+        }
+        const double x = (p[0] - '0') * unit;
+        const double y = (p[1] - '2') * unit;
+        p += 2;
+        if (isStrokeStart) {
+            rv << dao::PathSegment{ .type = dao::PathSegment::Move, .x = x, .y = y };
+            // single points are drawn as a dot
+            if (*p == ' ' || *p == 0) rv << dao::PathSegment{ .type = dao::PathSegment::Line, .x = x, .y = y, .r = r, .g = g, .b = b };
+            isStrokeStart = false;
+        } else {
+            rv << dao::PathSegment{ .type = dao::PathSegment::Line, .x = x, .y = y, .r = r, .g = g, .b = b };
+        }
+    }
+    return rv;
+}
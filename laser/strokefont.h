@@ -0,0 +1,17 @@
+#pragma once
+
+#include <dao/laserpath.h>
+
+// Single-stroke font (Hershey style) for ASCII 32 ... 126.
+// Glyphs are up to 4 units wide, cap height is 6 units above the baseline.
+// Lowercase letters are drawn as uppercase.
+class StrokeFont
+{
+public:
+    static constexpr int CapHeight  =  6;
+    static constexpr int Advance    =  6;
+    static constexpr int LineHeight = 10;
+
+    // Glyph path with origin at the left end of the baseline, scaled by unit.
+    static dao::LaserPath glyph(char c, double unit, quint8 r, quint8 g, quint8 b);
+};
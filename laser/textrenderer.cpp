@@ -0,0 +1,81 @@
+#include "textrenderer.h"
+
+#include <laser/blanking.h>
+#include <laser/laser.h>
+#include <laser/strokefont.h>
+
+#include <cflib/util/log.h>
+
+USE_LOG(LogCat::Compute)
+
+namespace {
+
+constexpr int Center    = 2048;  // device coordinate of 0.0
+constexpr int MaxGlyphs = 4096;
+
+}
+
+TextRenderer::TextRenderer() :
+    flattener_(PathFlattener::Config{ .cacheSize = 0 })
+{
+}
+
+const EasyLase::Points & TextRenderer::glyph(const GlyphKey & key)
+{
+    auto it = cache_.constFind(key);
+    if (it != cache_.constEnd()) {
+        ++cacheHits_;
+        return *it;
+    }
+
+    ++cacheMisses_;
+    if (cache_.size() >= MaxGlyphs) cache_.clear();
+
+    const double unit = key.size / StrokeFont::CapHeight;
+    EasyLase::Points points = Laser::convert(flattener_.flatten(StrokeFont::glyph(key.c, unit, key.r, key.g, key.b)), key.pps);
+    for (EasyLase::Point & p : points) {
+        p.x = quint16(p.x - Center);
+        p.y = quint16(p.y - Center);
+    }
+    return *cache_.insert(key, points);
+}
+
+EasyLase::Points TextRenderer::render(const QString & text, double x, double y, double size,
+    quint8 r, quint8 g, quint8 b, quint16 pps)
+{
+    const double unit = size / StrokeFont::CapHeight;
+    EasyLase::Points rv;
+    double penX = x;
+    double penY = y;
+    for (char c : text.toLatin1()) {
+        if (c == '\n') {
+            penX  = x;
+            penY -= StrokeFont::LineHeight * unit;
+            continue;
+        }
+        const EasyLase::Points & glyphPoints = glyph(GlyphKey{ c, r, g, b, pps, size });
+        if (!glyphPoints.isEmpty()) {
+            const EasyLase::Point origin = Laser::convert(Laser::Point{ .x = penX, .y = penY });
+            auto place = [&origin](EasyLase::Point p) {
+                p.x = qBound(0, origin.x + (qint16)p.x, 4095);
+                p.y = qBound(0, origin.y + (qint16)p.y, 4095);
+                return p;
+            };
+
+            if (!rv.isEmpty()) appendBlankJump(rv, rv.last(), place(glyphPoints.first()));
+            const qsizetype start = rv.size();
+            const qsizetype count = glyphPoints.size();
+            rv.resize(start + count);
+            const EasyLase::Point * src = glyphPoints.constData();
+            EasyLase::Point       * dst = rv.data() + start;
+            for (qsizetype i = 0 ; i < count ; ++i) dst[i] = place(src[i]);
+        }
+        penX += StrokeFont::Advance * unit;
+    }
+    // content gets repeated
+    if (!rv.isEmpty()) appendBlankJump(rv, rv.last(), rv.first());
+
+    logTrace("rendered %1 chars to %2 points (glyph cache hits: %3, misses: %4)",
+        text.size(), rv.size(), cacheHits_, cacheMisses_);
+    return rv;
+}
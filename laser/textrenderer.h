@@ -0,0 +1,44 @@
+#pragma once
+
+#include <laser/easylase.h>
+#include <laser/pathflattener.h>
+
+// Renders strings with StrokeFont. Every glyph is flattened and converted only once
+// per size, color and speed. Strings are assembled by copying and translating these
+// cached runs with blank jumps in between.
+// This class has no threading.
+class TextRenderer
+{
+public:
+    TextRenderer();
+
+    // x, y: left end of the baseline of the first line; size: cap height
+    EasyLase::Points render(const QString & text, double x, double y, double size,
+        quint8 r, quint8 g, quint8 b, quint16 pps);
+
+    int cacheHits()   const { return cacheHits_;   }
+    int cacheMisses() const { return cacheMisses_; }
+
+private:
+    struct GlyphKey
+    {
+        char    c;
+        quint8  r;
+        quint8  g;
+        quint8  b;
+        quint16 pps;
+        double  size;
+
+        bool operator==(const GlyphKey &) const = default;
+        friend size_t qHash(const GlyphKey & k, size_t seed = 0) { return qHashMulti(seed, k.c, k.r, k.g, k.b, k.pps, k.size); }
+    };
+
+    // points are relative to the glyph origin (qint16 stored in x and y)
+    const EasyLase::Points & glyph(const GlyphKey & key);
+
+private:
+    PathFlattener                     flattener_;
+    QHash<GlyphKey, EasyLase::Points> cache_;
+    int                               cacheHits_   = 0;
+    int                               cacheMisses_ = 0;
+};
@@ -1,4 +1,7 @@
+#include <idnsender.h>
+#include <laser/idnreceiver.h>
 #include <laser/laser.h>
+#include <laser/shmserver.h>
 #include <services/laserservice.h>
 #include <stream.h>
 
@@ -28,13 +31,29 @@ QTextStream err(stderr);
 int showUsage(const QByteArray & executable)
 {
     err
-        << "Usage: " << executable << " [options] <cmd>"             << Qt::endl
-        << "Options:"                                                << Qt::endl
-        << "  -h, --help        => this help"                        << Qt::endl
-        << "  -l, --log <level> => set log level 1 -> all, 7 -> off" << Qt::endl
-        << "Commands:"                                               << Qt::endl
-        << "  off               => turns Laser off"                  << Qt::endl
-        << "  beam              => shows one soft beam at center"    << Qt::endl;
+        << "Usage: " << executable << " [options] <cmd>"                           << Qt::endl
+        << "Options:"                                                              << Qt::endl
+        << "  -h, --help               => this help"                                 << Qt::endl
+        << "  -l, --log <level>        => set log level 1 -> all, 7 -> off"          << Qt::endl
+        << "  -r, --realtime <policy>  => scheduling of laser and stream thread:"    << Qt::endl
+        << "                              normal, fifo[:prio], deadline[:rt/period]" << Qt::endl
+        << "                              (deadline times in us)"                    << Qt::endl
+        << "  -c, --cpus <list>        => pin laser thread to cpus, e.g. 3 or 2-3"   << Qt::endl
+        << "  -s, --stream-cpus <list> => pin stream thread to cpus"                 << Qt::endl
+        << "  -m, --mlock              => lock and prefault memory"                  << Qt::endl
+        << "  -a, --address <ip>       => IDN address to bind to / to send to"       << Qt::endl
+        << "  -p, --port <port>        => IDN port (default: 7255)"                  << Qt::endl
+        << "  -j, --jitter <ms>        => IDN jitter buffer (default: 20)"           << Qt::endl
+        << "  -f, --frames             => idn-send sends frames instead of wave"     << Qt::endl
+        << "  -u, --unix <path>        => socket for shared memory clients"          << Qt::endl
+        << "                              (default: /tmp/cflase.sock, web: off)"     << Qt::endl
+        << "  -x, --mirror             => mirror output for rear mounted projectors" << Qt::endl
+        << "Commands:"                                                             << Qt::endl
+        << "  off                      => turns Laser off"                           << Qt::endl
+        << "  beam                     => shows one soft beam at center"             << Qt::endl
+        << "  idn                      => shows IDN stream received over UDP"        << Qt::endl
+        << "  idn-send                 => sends test stream over IDN"                << Qt::endl
+        << "  shm                      => shows frames of shared memory clients"     << Qt::endl;
     return 1;
 }
 
@@ -43,12 +62,46 @@ int showUsage(const QByteArray & executable)
 int main(int argc, char *argv[])
 {
     CmdLine cmdLine(argc, argv);
-    Option help     ('h', "help"        ); cmdLine << help;
-    Option logOpt   ('l', "log",    true); cmdLine << logOpt;
-    Option exportOpt('e', "export", true); cmdLine << exportOpt;
-    Arg    cmdArg                        ; cmdLine << cmdArg;
+    Option help     ('h', "help"              ); cmdLine << help;
+    Option logOpt   ('l', "log",         true); cmdLine << logOpt;
+    Option exportOpt('e', "export",      true); cmdLine << exportOpt;
+    Option rtOpt    ('r', "realtime",    true); cmdLine << rtOpt;
+    Option cpusOpt  ('c', "cpus",        true); cmdLine << cpusOpt;
+    Option sCpusOpt ('s', "stream-cpus", true); cmdLine << sCpusOpt;
+    Option mlockOpt ('m', "mlock"             ); cmdLine << mlockOpt;
+    Option addrOpt  ('a', "address",     true); cmdLine << addrOpt;
+    Option portOpt  ('p', "port",        true); cmdLine << portOpt;
+    Option jitterOpt('j', "jitter",      true); cmdLine << jitterOpt;
+    Option framesOpt('f', "frames"            ); cmdLine << framesOpt;
+    Option unixOpt  ('u', "unix",        true); cmdLine << unixOpt;
+    Option mirrorOpt('x', "mirror"            ); cmdLine << mirrorOpt;
+    Arg    cmdArg                              ; cmdLine << cmdArg;
     if (!cmdLine.parse() || help.isSet()) return showUsage(cmdLine.executable());
 
+    // real-time settings
+    realtime::Config laserRt;
+    if (rtOpt.isSet()   && !realtime::parsePolicy(rtOpt.value(), laserRt)) return showUsage(cmdLine.executable());
+    if (cpusOpt.isSet() && !realtime::parseCpus(cpusOpt.value(), laserRt)) return showUsage(cmdLine.executable());
+    realtime::Config streamRt = laserRt;
+    streamRt.cpus.clear();
+    if (sCpusOpt.isSet() && !realtime::parseCpus(sCpusOpt.value(), streamRt)) return showUsage(cmdLine.executable());
+    // the generator must never preempt the device thread
+    if (streamRt.policy == realtime::Policy::Deadline) streamRt.policy = realtime::Policy::Fifo;
+    streamRt.priority = qMax(1, laserRt.priority - 1);
+    const bool isRealtime = rtOpt.isSet() || cpusOpt.isSet();
+
+    // IDN settings
+    IdnReceiver::Config idnConfig;
+    bool isValid = true;
+    if (addrOpt.isSet())   idnConfig.address = addrOpt.value();
+    if (portOpt.isSet())   idnConfig.port    = portOpt.value().toUShort(&isValid);
+    if (jitterOpt.isSet() && isValid) idnConfig.jitter = jitterOpt.value().toInt(&isValid);
+    if (!isValid || idnConfig.port == 0 || idnConfig.jitter < 0) return showUsage(cmdLine.executable());
+
+    // mounting correction
+    dao::CorrectionConfig correction;
+    if (mirrorOpt.isSet()) correction.matrix = { -1, 0, 0,  0, 1, 0,  0, 0, 1 };
+
     // application loop
     QCoreApplication a(argc, argv);
     UnixSignal unixSignal(true);
@@ -65,7 +118,11 @@ int main(int argc, char *argv[])
         Log::setLogLevel(logOpt.value().toUShort());
     }
 
-    auto initLaser = []() {
+    if (mlockOpt.isSet() && !realtime::lockMemory(64 * 1024 * 1024)) {
+        err << "warning: memory is not locked" << Qt::endl;
+    }
+
+    auto initLaser = [&]() {
         std::unique_ptr<Laser> laser = std::make_unique<Laser>();
         laser->setErrorCallback([](const QString & error) {
             QTextStream(stderr) << "error: " << error << Qt::endl;
@@ -73,10 +130,27 @@ int main(int argc, char *argv[])
         laser->setActiveCallback([](bool active) {
             QTextStream(stdout) << "laser: " << (active ? "on" : "off") << Qt::endl;
         });
+        laser->setOutputCorrection(OutputCorrection(correction));
         laser->reset();
-        if (laser->hasError()) laser = {};
+        if (laser->hasError()) return std::unique_ptr<Laser>();
+        if (isRealtime && !laser->setRealtime(laserRt)) {
+            err << "warning: laser thread runs without full real-time settings" << Qt::endl;
+        }
         return laser;
     };
+    auto printTimerStats = [](const Laser & laser) {
+        const dao::TimerStats ts = laser.timerStats();
+        QTextStream(stdout)
+            << "timer latency: mean " << qRound(ts.meanLatency) << "us, max " << qRound(ts.maxLatency)
+            << "us, late " << ts.lateCount << " of " << ts.count << Qt::endl;
+        const dao::RecoveryStats rs = laser.recoveryStats();
+        if (rs.errors > 0) {
+            QTextStream(stdout)
+                << "device recovery: " << rs.reconnects << " of " << rs.errors << " errors, last "
+                << qRound(rs.lastRecovery) << "ms, max " << qRound(rs.maxRecovery) << "ms, "
+                << rs.failedAttempts << " failed attempts" << Qt::endl;
+        }
+    };
 
     // commands
     const QByteArray cmd = cmdArg.value();
@@ -101,18 +175,62 @@ int main(int argc, char *argv[])
         laser->show({.g = 35});
     } else if (cmd == "test") {
         Stream stream;
+        if (sCpusOpt.isSet() || rtOpt.isSet()) stream.setRealtime(streamRt);
         auto laser = initLaser();
         if (!laser) return 2;
         out << "showing test ..." << Qt::endl;
-        laser->setFinishedCallback([&]() { laser->show(stream.getNext()); });
+        laser->setFinishedCallback([&](int) { laser->show(stream.getNext()); });
         laser->show(stream.getFirst());
+        int rv = runLoop();
+        printTimerStats(*laser);
+        return rv;
+    } else if (cmd == "idn") {
+        auto laser = initLaser();
+        if (!laser) return 2;
+        IdnReceiver receiver(*laser);
+        if (!receiver.start(idnConfig)) return 2;
+        out << "receiving IDN on port " << idnConfig.port << " ..." << Qt::endl;
+        int rv = runLoop();
+        const IdnReceiver::Stats st = receiver.stats();
+        QTextStream(stdout)
+            << "idn: " << st.packets << " packets, " << st.lost << " lost, " << st.late << " late, "
+            << st.invalid << " invalid, " << st.overflows << " overflows, " << st.underruns << " underruns, "
+            << st.chunks << " chunks, " << st.frames << " frames" << Qt::endl;
+        printTimerStats(*laser);
+        return rv;
+    } else if (cmd == "idn-send") {
+        Stream stream;
+        if (sCpusOpt.isSet() || rtOpt.isSet()) stream.setRealtime(streamRt);
+        IdnSender sender(stream);
+        const QByteArray address = addrOpt.isSet() ? addrOpt.value() : QByteArray("127.0.0.1");
+        if (!sender.start(address, idnConfig.port, framesOpt.isSet())) return 2;
+        out << "sending test stream to " << address << ":" << idnConfig.port << " ..." << Qt::endl;
         return runLoop();
+    } else if (cmd == "shm") {
+        auto laser = initLaser();
+        if (!laser) return 2;
+        ShmServer shmServer(*laser);
+        const QByteArray path = unixOpt.isSet() ? unixOpt.value() : QByteArray(ShmServer::DefaultPath);
+        if (!shmServer.start(path)) return 2;
+        out << "waiting for shared memory clients on " << path << " ..." << Qt::endl;
+        int rv = runLoop();
+        printTimerStats(*laser);
+        return rv;
     } else if (cmd == "web" || exportOpt.isSet()) {
         HttpServer serv(1);
         WSCommManager<int> commMgr("/ws");     serv.registerHandler(commMgr);
         RMIServer<int>     rmiServer(commMgr); serv.registerHandler(rmiServer);
 
         LaserService laserService; rmiServer.registerService(laserService);
+        laserService.setOutputCorrection(correction);
+        if (isRealtime && !laserService.setRealtime(laserRt)) {
+            err << "warning: laser thread runs without full real-time settings" << Qt::endl;
+        }
+        std::unique_ptr<ShmServer> shmServer;
+        if (unixOpt.isSet() && !exportOpt.isSet()) {
+            shmServer = std::make_unique<ShmServer>(laserService.laser());
+            if (!shmServer->start(unixOpt.value())) return 2;
+        }
 
         if (exportOpt.isSet()) {
             rmiServer.exportTo(exportOpt.value());
@@ -6,8 +6,16 @@ USE_LOG(LogCat::Http)
 
 namespace services {
 
+namespace {
+
+constexpr int MaxDeltaStreams = 16;
+
+}
+
 LaserService::LaserService() :
-    RMIService(serializeTypeInfo().typeName)
+    RMIService(serializeTypeInfo().typeName),
+    previewSink_(std::make_shared<PreviewSink>([this](const dao::LaserPoints & points) { preview(points); })),
+    compositor_(laser_)
 {
     laser_.setErrorCallback([this](const QString & msg) {
         logDebug("signaling error: %1", msg);
@@ -17,43 +25,301 @@ LaserService::LaserService() :
         logDebug("signaling active: %1", onOff);
         active(onOff);
     });
-    laser_.setFinishedCallback([this]() {
-        logDebug("signaling finished");
-        finished();
+    laser_.setFinishedCallback([this](int remaining) { signalFinished(remaining); });
+    laser_.setPresentedCallback([this](qint64 target, qint64 start) {
+        logDebug("signaling presented: %1us late", start - target);
+        presented(target, start);
     });
+    laser_.setCueCallback([this](quint8 ttl, qint64 target, qint64 actual) {
+        logTrace("signaling cue %1: %2us late", ttl, actual - target);
+        cue(ttl, target, actual);
+    });
+    // only the newest frame matters for previews
+    previewSinkId_ = laser_.addFrameSink(previewSink_, FrameFanout::Config{ .queueSize = 1, .policy = FrameFanout::DropOldest });
     laser_.reset();
 }
 
 LaserService::~LaserService()
 {
+    laser_.removeFrameSink(previewSinkId_);
     stopVerifyThread();
 }
 
-bool LaserService::on()
+bool LaserService::on(quint32 token)
 {
-    laser_.on();
-    laser_.waitForFinish();
-    return !laser_.hasError();
+    laser_.on([this, token](bool ok) { signalCompleted("on", token, ok); });
+    return !laser_.hasErrorNow();
 }
 
-bool LaserService::off()
+bool LaserService::off(quint32 token)
 {
-    laser_.off();
-    laser_.waitForFinish();
-    return !laser_.hasError();
+    laser_.off([this, token](bool ok) { signalCompleted("off", token, ok); });
+    return !laser_.hasErrorNow();
 }
 
-bool LaserService::idle()
+bool LaserService::idle(quint32 token)
 {
-    laser_.idle();
-    laser_.waitForFinish();
-    return !laser_.hasError();
+    isSceneActive_ = false;
+    laser_.idle([this, token](bool ok) { signalCompleted("idle", token, ok); });
+    return !laser_.hasErrorNow();
 }
 
 bool LaserService::show(const dao::LaserPoints & points, bool repeat, quint16 pps)
 {
+    isSceneActive_ = false;
     laser_.show(points, repeat, pps);
-    return !laser_.hasError();
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::showWithCues(const dao::LaserPoints & points, bool repeat, quint16 pps, const dao::LaserCues & cues)
+{
+    isSceneActive_ = false;
+    laser_.show(points, repeat, pps, cues);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::showAt(qint64 time, const dao::LaserPoints & points, bool repeat, quint16 pps, const dao::LaserCues & cues)
+{
+    isSceneActive_ = false;
+    laser_.showAt(time, points, repeat, pps, cues);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::showWithTargetRate(const dao::LaserPoints & points, quint16 pps, double targetRate)
+{
+    isSceneActive_ = false;
+    laser_.show(points, true, pps, Laser::Cues(), qMax(0.0, targetRate));
+    return !laser_.hasErrorNow();
+}
+
+qint64 LaserService::clockTime()
+{
+    return Laser::now();
+}
+
+double LaserService::devicePps()
+{
+    return laser_.devicePps();
+}
+
+bool LaserService::showPath(const dao::LaserPath & path, bool repeat, quint16 pps)
+{
+    isSceneActive_ = false;
+    laser_.show(pathFlattener_.flatten(path), repeat, pps);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::showText(const QString & text, double x, double y, double size, quint8 r, quint8 g, quint8 b, quint16 pps)
+{
+    // like show(...), no speed means idle
+    if (pps == 0) {
+        isSceneActive_ = false;
+        laser_.idle();
+        return !laser_.hasErrorNow();
+    }
+    isSceneActive_ = false;
+    laser_.showConverted(textRenderer_.render(text, x, y, size, r, g, b, pps), true);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::beginStream(quint16 pps)
+{
+    isSceneActive_ = false;
+    laser_.beginStream(pps);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::appendStream(const dao::LaserPoints & points)
+{
+    return laser_.appendStream(points) && !laser_.hasErrorNow();
+}
+
+bool LaserService::endStream(bool repeat)
+{
+    laser_.endStream(repeat);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::showDelta(const dao::FrameDelta & delta, bool repeat, quint16 pps)
+{
+    const DeltaDecoder * decoder = applyDelta(delta);
+    if (!decoder) return false;
+    isSceneActive_ = false;
+    laser_.show(decoder->frame(), repeat, pps);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::appendStreamDelta(const dao::FrameDelta & delta)
+{
+    const DeltaDecoder * decoder = applyDelta(delta);
+    return decoder && laser_.appendStream(decoder->frame()) && !laser_.hasErrorNow();
+}
+
+bool LaserService::setPathOptimization(bool enabled)
+{
+    PathOptimizer::Config config;
+    config.enabled = enabled;
+    laser_.setPathOptimizer(config);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::setResampling(qint32 pointBudget)
+{
+    Resampler::Config config;
+    config.pointBudget = qMax(0, pointBudget);
+    laser_.setResampler(config);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::setOutputCorrection(const dao::CorrectionConfig & config)
+{
+    laser_.setOutputCorrection(OutputCorrection(config));
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::setSeamlessSwitching(bool seamless, bool blankedTransition)
+{
+    laser_.setSeamlessSwitching(seamless, blankedTransition);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::setFinishedLeadTime(qint32 leadTime)
+{
+    laser_.setFinishedCallback([this](int remaining) { signalFinished(remaining); }, leadTime);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::setPreview(qint32 pointBudget, double maxRate)
+{
+    previewSink_->setConfig(PreviewSink::Config{ .pointBudget = qMax(0, pointBudget), .maxRate = maxRate });
+    return !laser_.hasErrorNow();
+}
+
+dao::TimerStats LaserService::timerStats()
+{
+    return laser_.timerStats();
+}
+
+bool LaserService::resetTimerStats()
+{
+    laser_.resetTimerStats();
+    return !laser_.hasErrorNow();
+}
+
+double LaserService::switchLatency()
+{
+    return laser_.switchLatency() * 1000;
+}
+
+dao::RecoveryStats LaserService::recoveryStats()
+{
+    return laser_.recoveryStats();
+}
+
+dao::ContentCacheStats LaserService::contentCacheStats()
+{
+    return laser_.contentCacheStats();
+}
+
+dao::LevelOfDetailStats LaserService::levelOfDetailStats()
+{
+    return laser_.levelOfDetailStats();
+}
+
+bool LaserService::setSceneObject(const QString & id, const dao::SceneObject & object)
+{
+    scene_.setObject(id, object);
+    return updateScene();
+}
+
+bool LaserService::removeSceneObject(const QString & id)
+{
+    if (!scene_.removeObject(id)) return !laser_.hasErrorNow();
+    return updateScene();
+}
+
+bool LaserService::clearScene()
+{
+    scene_.clear();
+    return updateScene();
+}
+
+bool LaserService::showScene(quint16 pps)
+{
+    // like show(...), no speed means idle
+    if (pps == 0) {
+        isSceneActive_ = false;
+        laser_.idle();
+        return !laser_.hasErrorNow();
+    }
+    scene_.setSpeed(pps);
+    isSceneActive_ = true;
+    return updateScene();
+}
+
+bool LaserService::setZone(const QString & name, quint16 pps, qint32 pointBudget, qint32 order)
+{
+    if (pps == 0) return false;
+    const Compositor::ZoneConfig config{ .pps = pps, .pointBudget = qMax(0, pointBudget), .order = order };
+    return compositor_.setZone(name, config) && !laser_.hasErrorNow();
+}
+
+bool LaserService::removeZone(const QString & name)
+{
+    compositor_.removeZone(name);
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::clearZones()
+{
+    compositor_.clear();
+    return !laser_.hasErrorNow();
+}
+
+bool LaserService::showZone(const QString & name, const dao::LaserPoints & points, bool repeat)
+{
+    isSceneActive_ = false;
+    return compositor_.show(name, points, repeat) && !laser_.hasErrorNow();
+}
+
+bool LaserService::appendZone(const QString & name, const dao::LaserPoints & points)
+{
+    isSceneActive_ = false;
+    return compositor_.append(name, points) && !laser_.hasErrorNow();
+}
+
+bool LaserService::updateScene()
+{
+    if (isSceneActive_) laser_.showConverted(scene_.render(), true);
+    return !laser_.hasErrorNow();
+}
+
+const DeltaDecoder * LaserService::applyDelta(const dao::FrameDelta & delta)
+{
+    // streams are never closed, key frames of new streams replace the least recently used one
+    auto it = deltaStreams_.find(delta.stream);
+    if (it == deltaStreams_.end()) {
+        if (delta.baseSeq != 0) return nullptr;
+        if (deltaStreams_.size() >= MaxDeltaStreams) {
+            deltaStreams_.erase(std::min_element(deltaStreams_.begin(), deltaStreams_.end(),
+                [](const DeltaStream & a, const DeltaStream & b) { return a.lastUse < b.lastUse; }));
+        }
+        it = deltaStreams_.insert(delta.stream, DeltaStream());
+    }
+    it->lastUse = ++deltaUses_;
+    return it->decoder.apply(delta) ? &it->decoder : nullptr;
+}
+
+void LaserService::signalFinished(int remaining)
+{
+    logDebug("signaling finished: %1ms remaining", remaining);
+    finished(remaining);
+}
+
+void LaserService::signalCompleted(const QString & command, quint32 token, bool ok)
+{
+    logTrace("signaling completed: %1 (%2) %3", command, token, ok);
+    completed(command, token, ok);
 }
 
 }
@@ -1,6 +1,21 @@
 #pragma once
 
+#include <dao/contentcachestats.h>
+#include <dao/correctionconfig.h>
+#include <dao/framedelta.h>
+#include <dao/lasercue.h>
+#include <dao/laserpath.h>
+#include <dao/levelofdetailstats.h>
+#include <dao/recoverystats.h>
+#include <dao/sceneobject.h>
+#include <dao/timerstats.h>
+#include <laser/compositor.h>
+#include <laser/deltadecoder.h>
 #include <laser/laser.h>
+#include <laser/pathflattener.h>
+#include <laser/previewsink.h>
+#include <laser/scene.h>
+#include <laser/textrenderer.h>
 #include <cflib/net/rmiservice.h>
 
 namespace services {
@@ -13,20 +28,114 @@ public:
     LaserService();
     ~LaserService();
 
+    bool setRealtime(const realtime::Config & config) { return laser_.setRealtime(config); }
+    // for local interfaces besides RMI
+    Laser & laser() { return laser_; }
+
 rmi:
-    bool on();
-    bool off();
+    // Commands return at once without waiting for the laser thread: true means the command was accepted
+    // (false, if the device had an error already), errors of the execution are signaled with error.
+    // Appends to streams report a full buffer as well, see there.
+
+    // The result of the execution is signaled with completed, along with the token of the client.
+    bool on(quint32 token);
+    bool off(quint32 token);
+    bool idle(quint32 token);
 
-    bool idle();
     bool show(const dao::LaserPoints & points, bool repeat, quint16 pps);
+    // cues are signaled with cue when issued,
+    // with repeat they are exact only without path optimization and resampling
+    bool showWithCues(const dao::LaserPoints & points, bool repeat, quint16 pps, const dao::LaserCues & cues);
+    // time in us of clockTime(), start is signaled with presented
+    bool showAt(qint64 time, const dao::LaserPoints & points, bool repeat, quint16 pps, const dao::LaserCues & cues);
+    // repeated, simplified until it refreshes targetRate times per second, see levelOfDetailStats
+    bool showWithTargetRate(const dao::LaserPoints & points, quint16 pps, double targetRate);
+    qint64 clockTime();
+    double devicePps();
+    bool showPath(const dao::LaserPath & path, bool repeat, quint16 pps);
+    // x, y: left end of baseline, size: cap height
+    bool showText(const QString & text, double x, double y, double size, quint8 r, quint8 g, quint8 b, quint16 pps);
+
+    // Streaming session: append returns false, if the chunk was rejected (buffer full or error).
+    // Rejected chunks should be sent again later.
+    bool beginStream(quint16 pps);
+    bool appendStream(const dao::LaserPoints & points);
+    bool endStream(bool repeat);
+
+    // Frames as changes to the previous frame of the same client stream (see dao::FrameDelta).
+    // false, if the delta does not fit the last frame of its stream: a key frame has to follow.
+    bool showDelta(const dao::FrameDelta & delta, bool repeat, quint16 pps);
+    bool appendStreamDelta(const dao::FrameDelta & delta);
+
+    // both apply to repeated content only
+    bool setPathOptimization(bool enabled);
+    bool setResampling(qint32 pointBudget);
+    // points outside -2.0 ... 2.0 are clamped before the correction
+    bool setOutputCorrection(const dao::CorrectionConfig & config);
+    bool setSeamlessSwitching(bool seamless, bool blankedTransition);
+    // finished is signaled leadTime ms before one-shot content ends
+    bool setFinishedLeadTime(qint32 leadTime);
+    // preview is signaled at most maxRate times per second with up to pointBudget points (0 -> off)
+    bool setPreview(qint32 pointBudget, double maxRate);
+
+    dao::TimerStats timerStats();
+    bool resetTimerStats();
+    // ms from the last seamless switch request until the new content was visible
+    double switchLatency();
+    dao::RecoveryStats recoveryStats();
+    dao::ContentCacheStats contentCacheStats();
+    dao::LevelOfDetailStats levelOfDetailStats();
+
+    // Retained-mode scene: after showScene(...) every change is shown immediately.
+    bool setSceneObject(const QString & id, const dao::SceneObject & object);
+    bool removeSceneObject(const QString & id);
+    bool clearScene();
+    bool showScene(quint16 pps);
+
+    // Zones of several clients shown together, content is shown as soon as it is set.
+    // pointBudget: device points per composed frame, order: drawing order, pps 0 is rejected,
+    // as well as more than 16 zones
+    bool setZone(const QString & name, quint16 pps, qint32 pointBudget, qint32 order);
+    bool removeZone(const QString & name);
+    bool clearZones();
+    // both are false for zones that were not set
+    bool showZone(const QString & name, const dao::LaserPoints & points, bool repeat);
+    // false, if the zone buffers too many points, the chunk should be sent again later
+    bool appendZone(const QString & name, const dao::LaserPoints & points);
 
 cfsignals:
     rsig<void (const QString & error), void ()> error;
     rsig<void (bool active), void ()> active;
-    rsig<void (), void ()> finished;
+    rsig<void (qint32 remaining), void ()> finished;
+    rsig<void (qint64 target, qint64 start), void ()> presented;
+    rsig<void (quint8 ttl, qint64 target, qint64 actual), void ()> cue;
+    rsig<void (const dao::LaserPoints & points), void ()> preview;
+    rsig<void (const QString & command, quint32 token, bool ok), void ()> completed;
+
+private:
+    bool updateScene();
+    const DeltaDecoder * applyDelta(const dao::FrameDelta & delta);
+    void signalFinished(int remaining);
+    void signalCompleted(const QString & command, quint32 token, bool ok);
+
+private:
+    struct DeltaStream
+    {
+        DeltaDecoder decoder;
+        quint64      lastUse = 0;
+    };
 
 private:
-    Laser laser_;
+    Laser                        laser_;
+    std::shared_ptr<PreviewSink> previewSink_;
+    int                          previewSinkId_ = 0;
+    PathFlattener                pathFlattener_;
+    TextRenderer                 textRenderer_;
+    Scene                        scene_;
+    bool                         isSceneActive_ = false;
+    Compositor                   compositor_;
+    QMap<quint32, DeltaStream>   deltaStreams_;
+    quint64                      deltaUses_ = 0;
 };
 
 }
@@ -16,6 +16,14 @@ Stream::~Stream()
     stopVerifyThread();
 }
 
+bool Stream::setRealtime(const realtime::Config & config)
+{
+    SyncedThreadCall<bool> stc(this);
+    if (!stc.verify(&Stream::setRealtime, config)) return stc.retval();
+    logFunctionTrace
+    return realtime::applyToCurrentThread(config);
+}
+
 Laser::Points Stream::getFirst()
 {
     SyncedThreadCall<Laser::Points> stc(this);
@@ -50,6 +58,7 @@ Laser::Points Stream::calcNext()
 
     int pc = Laser::OptimalPointCount;
     Laser::Points points;
+    points.reserve(pc);
     for (int i = 0 ; i < pc ; ++i) {
         points << Laser::Point{
             .x = std::cos(2 * Pi * i / pc) / 4,
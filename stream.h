@@ -11,6 +11,9 @@ public:
     Stream();
     ~Stream();
 
+    // Applies scheduling, cpu pinning and stack prefaulting to the generator thread.
+    bool setRealtime(const realtime::Config & config);
+
     Laser::Points getFirst();
     Laser::Points getNext();
 